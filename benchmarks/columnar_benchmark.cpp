@@ -0,0 +1,58 @@
+#include "jjson/columnar.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace jjson;
+
+template <typename F>
+static int64_t measure(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  auto t1 = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+}
+
+int main() {
+  constexpr int users = 500000;
+
+  std::string data = "[";
+
+  for (int i = 0; i < users; i++) {
+    data += (i > 0 ? ",\n" : "\n");
+    data += R"({"id": )" + std::to_string(i) + R"(, "name": "user )" + std::to_string(i) +
+      R"(", "email": "user)" + std::to_string(i) + R"(@example.com", "age": )" + std::to_string(18 + i % 60) +
+      R"(, "balance": )" + std::to_string(i % 1000) + R"(.25, "active": )" + (i % 3 == 0 ? "false" : "true") + "}";
+  }
+
+  data += "]";
+
+  double sum1 = 0.0;
+  double sum2 = 0.0;
+
+  auto t1 = measure([&]() {
+    auto doc = Json::parse(data).value();
+
+    for (auto const &user : doc.get_or_throw<jArray>()) {
+      if (user["active"].get<bool>().value()) {
+        sum1 += user["balance"].get<double>().value();
+      }
+    }
+  });
+
+  auto t2 = measure([&]() {
+    auto columns = parse_columns(data).value();
+    auto const &active = columns["active"].bools();
+    auto const &balance = columns["balance"].decimals();
+
+    for (std::size_t i = 0; i < balance.size(); i++) {
+      sum2 += active[i] ? balance[i] : 0.0;
+    }
+  });
+
+  std::cout << "size: " << data.size()/(1024*1024) << "MB" << std::endl;
+  std::cout << "dom: " << t1 << "ms" << std::endl;
+  std::cout << "columns: " << t2 << "ms" << std::endl;
+
+  return sum1 == sum2 ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+#include "jjson/convert.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace jjson;
+
+template <typename F>
+static int64_t measure(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  auto t1 = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+}
+
+struct Order {
+  int64_t id;
+  double total;
+  std::string customer;
+};
+
+// the same conversion, reporting failures by throwing
+struct ThrowingOrder : Order {
+};
+
+namespace jjson {
+  bool json_to(Json const &value, Order &out) {
+    if (!value.is_object() || !value.has("id") || !value.has("total") || !value.has("customer")) {
+      return false;
+    }
+
+    auto id = value["id"].get<int64_t>();
+    auto total = value["total"].get<double>();
+    auto const &customer = value["customer"];
+
+    if (!id || !total || !customer.is_text()) {
+      return false;
+    }
+
+    out = Order{*id, *total, customer.get_or_throw<std::string>()};
+    return true;
+  }
+
+  void json_to(Json const &value, ThrowingOrder &out) {
+    if (!json_to(value, static_cast<Order &>(out))) {
+      throw std::runtime_error("invalid order");
+    }
+  }
+}
+
+int main() {
+  constexpr int orders = 1000000;
+
+  std::vector<Json> values;
+
+  values.reserve(orders);
+
+  for (int i = 0; i < orders; i++) {
+    // one order in ten misses its total
+    if (i % 10 == 0) {
+      values.push_back(Json{{"id", int64_t{i}}, {"customer", "customer " + std::to_string(i)}});
+    } else {
+      values.push_back(Json{{"id", int64_t{i}}, {"total", i + 0.5}, {"customer", "customer " + std::to_string(i)}});
+    }
+  }
+
+  std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::size_t count = 0;
+
+  auto t1 = measure([&]() {
+    std::vector<std::optional<ThrowingOrder>> result;
+    for (auto const &value : values) {
+      result.push_back(value.get<ThrowingOrder>());
+    }
+    count += std::count_if(result.begin(), result.end(), [](auto const &item) { return item.has_value(); });
+  });
+
+  auto t2 = measure([&]() {
+    auto result = convert_all<Order>(values, 1);
+    count += std::count_if(result.begin(), result.end(), [](auto const &item) { return item.has_value(); });
+  });
+
+  auto t3 = measure([&]() {
+    auto result = convert_all<Order>(values, threads);
+    count += std::count_if(result.begin(), result.end(), [](auto const &item) { return item.has_value(); });
+  });
+
+  std::cout << "orders: " << orders << std::endl;
+  std::cout << "get<T> loop, throwing: " << t1 << "ms" << std::endl;
+  std::cout << "convert_all(1): " << t2 << "ms" << std::endl;
+  std::cout << "convert_all(" << threads << "): " << t3 << "ms" << std::endl;
+
+  return count == 3*(orders - orders/10) ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#include "jjson/json.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace jjson;
+
+template <typename F>
+static int64_t measure(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  auto t1 = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+}
+
+int main() {
+  constexpr int users = 500000;
+
+  jArray rows;
+
+  for (int i = 0; i < users; i++) {
+    rows.push_back(Json{jObject{
+      {"id", Json{int64_t{i}}},
+      {"name", Json{"user " + std::to_string(i)}},
+      {"email", Json{"user" + std::to_string(i) + "@example.com"}},
+      {"balance", Json{i % 1000 + 0.25}},
+      {"active", Json{i % 3 != 0}}}});
+  }
+
+  Json doc{std::move(rows)};
+  std::string single;
+  std::string parallel;
+  std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  auto t1 = measure([&]() {
+    single = doc.dump();
+  });
+
+  auto t2 = measure([&]() {
+    parallel = doc.dump_parallel(threads);
+  });
+
+  std::cout << "size: " << single.size()/(1024*1024) << "MB" << std::endl;
+  std::cout << "dump: " << t1 << "ms" << std::endl;
+  std::cout << "dump_parallel(" << threads << "): " << t2 << "ms" << std::endl;
+
+  return single == parallel ? 0 : 1;
+}
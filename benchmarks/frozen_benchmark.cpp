@@ -0,0 +1,58 @@
+#include "jjson/frozen.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace jjson;
+
+template <typename F>
+static int64_t measure(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  auto t1 = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+}
+
+int main() {
+  constexpr int routes = 10000;
+  constexpr int rounds = 200;
+
+  jObject table;
+  std::vector<std::string> keys;
+
+  for (int i = 0; i < routes; i++) {
+    keys.push_back("/api/v1/resource/" + std::to_string(i));
+    table.emplace(keys.back(), Json{
+      {"backend", "host-" + std::to_string(i % 16)},
+      {"weight", i}});
+  }
+
+  Json mutableTable{table};
+  auto frozenTable = freeze(mutableTable);
+  int64_t sum1 = 0;
+  int64_t sum2 = 0;
+
+  auto t1 = measure([&]() {
+    for (int r = 0; r < rounds; r++) {
+      for (auto const &key : keys) {
+        sum1 += mutableTable[key]["weight"].get<int64_t>().value();
+      }
+    }
+  });
+
+  auto t2 = measure([&]() {
+    auto root = frozenTable.root();
+    for (int r = 0; r < rounds; r++) {
+      for (auto const &key : keys) {
+        sum2 += root[key]["weight"].get<int64_t>().value();
+      }
+    }
+  });
+
+  std::cout << "lookups: " << routes*rounds*2 << std::endl;
+  std::cout << "Json::operator[]: " << t1 << "ms" << std::endl;
+  std::cout << "FrozenJson::operator[]: " << t2 << "ms" << std::endl;
+  std::cout << "layout: " << frozenTable.size_bytes() << " bytes" << std::endl;
+
+  return sum1 == sum2 ? 0 : 1;
+}
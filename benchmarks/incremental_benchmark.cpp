@@ -0,0 +1,58 @@
+#include "jjson/incremental.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace jjson;
+
+template <typename F>
+static int64_t measure(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  auto t1 = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+}
+
+int main() {
+  constexpr int users = 200000;
+  constexpr int edits = 1000;
+
+  std::string data = "{\"users\": [";
+
+  for (int i = 0; i < users; i++) {
+    if (i > 0) {
+      data += ", ";
+    }
+    data += R"({"id": )" + std::to_string(i) + R"(, "name": "user )" + std::to_string(i) +
+      R"(", "tags": ["a", "b", "c"], "balance": )" + std::to_string(i % 1000) + ".25}";
+  }
+
+  data += "]}";
+
+  std::optional<SourceDocument> document;
+
+  auto t1 = measure([&]() {
+    document = SourceDocument::parse(data);
+  });
+
+  // rewrites the balance of users spread over the document
+  auto t2 = measure([&]() {
+    for (int i = 0; i < edits; i++) {
+      auto const &source = document->source();
+      auto offset = source.find("\"balance\": ", source.size()/edits*i) + 11;
+
+      document->edit(offset, source.find('}', offset) - offset, std::to_string(i) + ".5");
+    }
+  });
+
+  auto t3 = measure([&]() {
+    Json::parse(document->source());
+  });
+
+  std::cout << "size: " << data.size()/(1024*1024) << "MB" << std::endl;
+  std::cout << "parse with spans: " << t1/1000 << "ms" << std::endl;
+  std::cout << "parse: " << t3/1000 << "ms" << std::endl;
+  std::cout << "edit: " << t2/edits << "us" << std::endl;
+
+  return document->json() == Json::parse(document->source()).value() ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#include "jjson/json.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace jjson;
+
+template <typename F>
+static int64_t measure(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  auto t1 = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+}
+
+int main() {
+  constexpr int rounds = 500000;
+
+  std::vector<std::string> messages;
+
+  for (int i = 0; i < 64; i++) {
+    messages.push_back(R"({"id": )" + std::to_string(i) + R"(, "type": "order.created", "paid": true, "total": )" +
+        std::to_string(i) + R"(.75, "items": [{"sku": "A-1", "qty": 2}, {"sku": "B-2", "qty": 1}], "customer": {"name": "customer name", "tier": "gold"}})");
+  }
+
+  std::size_t count = 0;
+
+  auto t1 = measure([&]() {
+    for (int i = 0; i < rounds; i++) {
+      count += Json::parse(messages[i % messages.size()]).has_value();
+    }
+  });
+
+  auto t5 = measure([&]() {
+    for (int i = 0; i < rounds; i++) {
+      count += Json::try_parse(messages[i % messages.size()]).has_value();
+    }
+  });
+
+  Parser parser;
+  Json doc;
+
+  auto t2 = measure([&]() {
+    for (int i = 0; i < rounds; i++) {
+      count += parser.parse_into(messages[i % messages.size()], doc);
+    }
+  });
+
+  std::string numbers = "[";
+
+  for (int i = 0; i < 2000000; i++) {
+    numbers += (i > 0 ? ", " : "") + std::to_string(i*37 % 100000) + "." + std::to_string(i % 997);
+  }
+
+  numbers += "]";
+
+  Parser raw{NumberMode::Raw};
+
+  auto t3 = measure([&]() {
+    count += parser.parse_into(numbers, doc);
+  });
+
+  auto t4 = measure([&]() {
+    count += raw.parse_into(numbers, doc);
+  });
+
+  std::cout << "messages: " << rounds << std::endl;
+  std::cout << "Json::parse: " << t1 << "ms" << std::endl;
+  std::cout << "Json::try_parse: " << t5 << "ms" << std::endl;
+  std::cout << "Parser::parse_into: " << t2 << "ms" << std::endl;
+  std::cout << "numbers: " << numbers.size()/(1024*1024) << "MB" << std::endl;
+  std::cout << "NumberMode::Convert: " << t3 << "ms" << std::endl;
+  std::cout << "NumberMode::Raw: " << t4 << "ms" << std::endl;
+
+  return count == 3*rounds + 2 ? 0 : 1;
+}
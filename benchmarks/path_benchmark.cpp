@@ -0,0 +1,57 @@
+#include "jjson/path.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace jjson;
+
+template <typename F>
+static int64_t measure(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  auto t1 = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+}
+
+int main() {
+  constexpr int items = 500000;
+
+  std::string data = R"({"meta": {"source": "benchmark"}, "items": [)";
+
+  for (int i = 0; i < items; i++) {
+    data += (i > 0 ? ", " : "");
+    data += R"({"id": )" + std::to_string(i) + R"(, "type": ")" + (i % 3 == 0 ? "donut" : "bagel") +
+      R"(", "name": "item number )" + std::to_string(i) + R"(", "price": )" + std::to_string(i % 20) +
+      R"(.5, "batters": [{"id": "1001", "type": "Regular"}, {"id": "1002", "type": "Chocolate"}], "notes": "some text that a query never reads"})";
+  }
+
+  data += "]}";
+
+  auto path = JsonPath::compile("$.items[?@.price > 10 && @.type == 'donut'].id").value();
+  std::size_t selected = 0;
+  std::size_t scanned = 0;
+
+  auto t2 = measure([&]() {
+    scanned = path.scan(data).value().size();
+  });
+
+  auto ids = JsonPath::compile("$.items[-10:].id").value();
+
+  auto t3 = measure([&]() {
+    scanned += ids.scan(data).value().size();
+  });
+
+  // last, so that freeing the tree doesn't weigh on the scans
+  auto t1 = measure([&]() {
+    auto document = Json::parse(data).value();
+    selected = path.select(document).size();
+  });
+
+  std::cout << "size: " << data.size()/(1024*1024) << "MB" << std::endl;
+  std::cout << "matches: " << selected << std::endl;
+  std::cout << "Json::parse + select: " << t1 << "ms" << std::endl;
+  std::cout << "scan with filter: " << t2 << "ms" << std::endl;
+  std::cout << "scan of the last ids: " << t3 << "ms" << std::endl;
+
+  return scanned == selected + 10 ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#include "jjson/projection.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace jjson;
+
+template <typename F>
+static int64_t measure(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  auto t1 = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+}
+
+int main() {
+  constexpr int records = 200000;
+
+  std::string data = "[";
+
+  for (int i = 0; i < records; i++) {
+    if (i > 0) {
+      data += ",";
+    }
+    data += R"({"timestamp": )" + std::to_string(1700000000 + i) +
+      R"(, "level": "info", "service": "gateway", "message": "request handled in the usual amount of time",)"
+      R"( "request": {"method": "GET", "path": "/api/v1/items/)" + std::to_string(i) + R"(", "headers": ["accept", "user-agent"]},)"
+      R"( "latency": )" + std::to_string(i % 1000) + ".25}";
+  }
+
+  data += "]";
+
+  std::optional<Json> full;
+  std::optional<Json> projected;
+
+  auto t1 = measure([&]() {
+    full = Json::parse(data);
+  });
+
+  auto t2 = measure([&]() {
+    projected = Json::parse(data, Projection{"latency", "request.method"});
+  });
+
+  std::cout << "input: " << data.size()/(1024*1024) << "MB" << std::endl;
+  std::cout << "full parse: " << t1 << "ms" << std::endl;
+  std::cout << "projected parse: " << t2 << "ms" << std::endl;
+
+  return full && projected && (*projected)[records - 1]["latency"] == 999.25 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+#include "jjson/json.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace jjson;
+
+template <typename F>
+static int64_t measure(F &&f) {
+  auto t0 = std::chrono::high_resolution_clock::now();
+  f();
+  auto t1 = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+}
+
+static std::string document(std::string const &text, int count) {
+  std::string data = "[";
+
+  for (int i = 0; i < count; i++) {
+    if (i > 0) {
+      data += ",";
+    }
+    data += "{\"title\": \"" + text + "\", \"body\": \"" + text + text + text + "\"}";
+  }
+
+  return data + "]";
+}
+
+static void run(std::string const &name, std::string const &data) {
+  std::optional<Json> value;
+
+  // warm up
+  value = Json::parse(data);
+
+  auto t = measure([&]() {
+    for (int i = 0; i < 5; i++) {
+      value = Json::parse(data);
+    }
+  });
+
+  double mb = 5.0*data.size()/(1024*1024);
+
+  std::cout << name << ": " << (value ? "ok" : "error") << ", " << t << "ms, " << static_cast<int>(mb*1000/std::max<int64_t>(t, 1)) << "MB/s" << std::endl;
+}
+
+int main() {
+  constexpr int count = 50000;
+
+  run("ascii", document("The quick brown fox jumps over the lazy dog, again and again, for a while", count));
+  run("escaped", document(R"(line 1\nline 2\n\t\"quoted\" path C:\\temp\\file \u00e9\u00e8)", count));
+  run("utf-8", document("Ação, coração, 日本語のテキスト, emoji 😀, και ελληνικά", count));
+
+  return 0;
+}
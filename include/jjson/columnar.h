@@ -0,0 +1,462 @@
+#pragma once
+
+#include "jjson/json.h"
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace jjson {
+
+  // One field of an array of objects, stored contiguously. Only the vector
+  // matching type() is used; null rows keep a zeroed slot there so that row i
+  // is always at index i, and validity() has bit i set for every non-null row.
+  class Column {
+
+    public:
+      std::string const & name() const {
+        return mName;
+      }
+
+      // Null while every row is null
+      JsonType type() const {
+        return mType;
+      }
+
+      std::size_t size() const {
+        return mSize;
+      }
+
+      bool is_null(std::size_t row) const {
+        return (mValidity[row/64] & (uint64_t{1} << (row % 64))) == 0;
+      }
+
+      std::vector<uint64_t> const & validity() const {
+        return mValidity;
+      }
+
+      std::vector<uint8_t> const & bools() const {
+        return mBools;
+      }
+
+      std::vector<int64_t> const & integers() const {
+        return mIntegers;
+      }
+
+      std::vector<double> const & decimals() const {
+        return mDecimals;
+      }
+
+      // text of row i is blob()[offsets()[i], offsets()[i + 1])
+      std::vector<uint64_t> const & offsets() const {
+        return mOffsets;
+      }
+
+      std::string const & blob() const {
+        return mBlob;
+      }
+
+      std::string_view text(std::size_t row) const {
+        return std::string_view{mBlob}.substr(mOffsets[row], mOffsets[row + 1] - mOffsets[row]);
+      }
+
+      Json json(std::size_t row) const {
+        if (row >= mSize) {
+          throw std::runtime_error("invalid access");
+        }
+
+        if (is_null(row)) {
+          return Json{};
+        }
+
+        switch (mType) {
+          case JsonType::Bool:
+            return Json{mBools[row] != 0};
+          case JsonType::Integer:
+            return Json{mIntegers[row]};
+          case JsonType::Decimal:
+            return Json{mDecimals[row]};
+          case JsonType::Text:
+            return Json{std::string{text(row)}};
+          default:
+            return Json{};
+        }
+      }
+
+    private:
+      friend class ColumnReader;
+
+      std::string mName;
+      JsonType mType = JsonType::Null;
+      std::size_t mSize = 0;
+      std::vector<uint64_t> mValidity;
+      std::vector<uint8_t> mBools;
+      std::vector<int64_t> mIntegers;
+      std::vector<double> mDecimals;
+      std::vector<uint64_t> mOffsets{0};
+      std::string mBlob;
+
+      Column(std::string name, JsonType type)
+        : mName{std::move(name)} {
+        _set_type(type);
+      }
+
+      // gives the rows already stored a zeroed slot in the new storage
+      void _set_type(JsonType type) {
+        mType = type;
+
+        switch (type) {
+          case JsonType::Bool:
+            mBools.resize(mSize);
+            break;
+          case JsonType::Integer:
+            mIntegers.resize(mSize);
+            break;
+          case JsonType::Decimal:
+            mDecimals.assign(mIntegers.begin(), mIntegers.end());
+            mDecimals.resize(mSize);
+            mIntegers = {};
+            break;
+          case JsonType::Text:
+            mOffsets.resize(mSize + 1, mBlob.size());
+            break;
+          default:
+            break;
+        }
+      }
+
+      void _push(bool valid) {
+        if (mSize % 64 == 0) {
+          mValidity.push_back(0);
+        }
+
+        if (valid) {
+          mValidity.back() |= uint64_t{1} << (mSize % 64);
+        }
+
+        mSize++;
+      }
+
+      void _push_null() {
+        switch (mType) {
+          case JsonType::Bool:
+            mBools.push_back(0);
+            break;
+          case JsonType::Integer:
+            mIntegers.push_back(0);
+            break;
+          case JsonType::Decimal:
+            mDecimals.push_back(0.0);
+            break;
+          case JsonType::Text:
+            mOffsets.push_back(mBlob.size());
+            break;
+          default:
+            break;
+        }
+
+        _push(false);
+      }
+
+  };
+
+  class Columns {
+
+    public:
+      std::size_t rows() const {
+        return mRows;
+      }
+
+      std::vector<Column> const & columns() const {
+        return mColumns;
+      }
+
+      Column const * find(std::string_view name) const {
+        for (auto const &column : mColumns) {
+          if (column.name() == name) {
+            return &column;
+          }
+        }
+        return nullptr;
+      }
+
+      Column const & operator [] (std::string_view name) const {
+        if (auto const *column = find(name)) {
+          return *column;
+        }
+        throw std::runtime_error("invalid access");
+      }
+
+    private:
+      friend class ColumnReader;
+
+      std::size_t mRows = 0;
+      std::vector<Column> mColumns;
+
+  };
+
+  // Parses an array of objects straight into columns, without building a
+  // Json per row. Without a schema the columns are inferred: they appear in
+  // the order their keys are first seen, take the type of their first
+  // non-null value and integers widen to decimals if a decimal shows up.
+  // With a schema only the listed members are read (the rest is skipped)
+  // and integers are accepted by decimal columns. Containers, values of
+  // another type and repeated keys in a row make the parse fail.
+  class ColumnReader {
+
+    public:
+      using schema_type = std::vector<std::pair<std::string, JsonType>>;
+
+      std::optional<Columns> parse(std::string_view data) {
+        mFixed = false;
+        return _parse(data, {});
+      }
+
+      std::optional<Columns> parse(std::string_view data, schema_type const &schema) {
+        for (auto const &[name, type] : schema) {
+          if (type == JsonType::Null || type == JsonType::Array || type == JsonType::Object) {
+            return {};
+          }
+        }
+
+        mFixed = true;
+        return _parse(data, schema);
+      }
+
+    private:
+      Parser mParser;
+      Json mScratch;
+      bool mFixed = false;
+      Columns mResult;
+      std::unordered_map<std::string, std::size_t> mIndex;
+      std::vector<std::size_t> mFilled; // row (+ 1) each column was last written
+      std::vector<std::size_t> mOrder; // columns in the order of the previous row
+
+      std::optional<Columns> _parse(std::string_view data, schema_type const &schema) {
+        auto &ps = mParser.mState;
+
+        ps = ParseState{data.data(), data.data() + data.size()};
+        mResult = Columns{};
+        mIndex.clear();
+        mFilled.clear();
+        mOrder.clear();
+
+        for (auto const &[name, type] : schema) {
+          _add(name, type);
+        }
+
+        ps.skip_space();
+
+        if (ps.get() != '[') {
+          return {};
+        }
+
+        ps.skip_space();
+
+        if (ps.peek() == ']') {
+          ps.get();
+          return std::move(mResult);
+        }
+
+        while (true) {
+          ps.skip_space();
+
+          if (ps.get() != '{' || !_read_row()) {
+            return {};
+          }
+
+          ps.skip_space();
+
+          int c = ps.get();
+
+          if (c == ']') {
+            break;
+          }
+
+          if (c != ',') {
+            return {};
+          }
+        }
+
+        return std::move(mResult);
+      }
+
+      std::size_t _add(std::string const &name, JsonType type) {
+        std::size_t index = mResult.mColumns.size();
+
+        mResult.mColumns.push_back(Column{name, type});
+        mIndex.emplace(name, index);
+        mFilled.push_back(0);
+
+        for (std::size_t i = 0; i < mResult.mRows; i++) {
+          mResult.mColumns.back()._push_null();
+        }
+
+        return index;
+      }
+
+      // same-shaped rows list their members in the same order, so the
+      // previous row predicts the column before the hash lookup
+      std::optional<std::size_t> _column(std::string const &key, std::size_t position) {
+        if (position < mOrder.size() && mResult.mColumns[mOrder[position]].mName == key) {
+          return mOrder[position];
+        }
+
+        if (auto i = mIndex.find(key); i != mIndex.end()) {
+          return i->second;
+        }
+
+        if (mFixed) {
+          return {};
+        }
+
+        return _add(key, JsonType::Null);
+      }
+
+      bool _read_row() {
+        auto &ps = mParser.mState;
+        std::size_t row = mResult.mRows + 1;
+        std::size_t position = 0;
+
+        ps.skip_space();
+
+        if (ps.peek() == '}') {
+          ps.get();
+        } else {
+          while (true) {
+            ps.skip_space();
+
+            if (ps.peek() != '"') {
+              return false;
+            }
+
+            mParser.mKey.clear();
+
+            if (!ps.read_string(mParser.mKey)) {
+              return false;
+            }
+
+            ps.skip_space();
+
+            if (ps.get() != ':') {
+              return false;
+            }
+
+            ps.skip_space();
+
+            auto index = _column(mParser.mKey, position);
+
+            if (!index) {
+              if (!ps.skip_value()) {
+                return false;
+              }
+            } else {
+              if (mFilled[*index] == row || !_read_value(mResult.mColumns[*index])) {
+                return false;
+              }
+
+              mFilled[*index] = row;
+
+              if (position < mOrder.size()) {
+                mOrder[position] = *index;
+              } else {
+                mOrder.push_back(*index);
+              }
+
+              position++;
+            }
+
+            ps.skip_space();
+
+            int c = ps.get();
+
+            if (c == '}') {
+              break;
+            }
+
+            if (c != ',') {
+              return false;
+            }
+          }
+        }
+
+        for (std::size_t i = 0; i < mFilled.size(); i++) {
+          if (mFilled[i] != row) {
+            mResult.mColumns[i]._push_null();
+          }
+        }
+
+        mResult.mRows++;
+
+        return true;
+      }
+
+      bool _read_value(Column &column) {
+        auto &ps = mParser.mState;
+        int c = ps.peek();
+
+        if (c == '"') {
+          if (column.mType == JsonType::Null && !mFixed) {
+            column._set_type(JsonType::Text);
+          }
+
+          if (column.mType != JsonType::Text || !ps.read_string(column.mBlob)) {
+            return false;
+          }
+
+          column.mOffsets.push_back(column.mBlob.size());
+          column._push(true);
+
+          return true;
+        }
+
+        if (c == -1 || c == '[' || c == '{' || !mParser._parse(mScratch, ParseFilter{})) {
+          return false;
+        }
+
+        JsonType type = mScratch.get_type();
+
+        if (type == JsonType::Null) {
+          column._push_null();
+          return true;
+        }
+
+        if (column.mType == JsonType::Null && !mFixed) {
+          column._set_type(type);
+        } else if (column.mType == JsonType::Integer && type == JsonType::Decimal && !mFixed) {
+          column._set_type(JsonType::Decimal);
+        }
+
+        if (column.mType == JsonType::Bool && type == JsonType::Bool) {
+          column.mBools.push_back(mScratch.get_or_throw<bool>() ? 1 : 0);
+        } else if (column.mType == JsonType::Integer && type == JsonType::Integer) {
+          column.mIntegers.push_back(mScratch.get_or_throw<int64_t>());
+        } else if (column.mType == JsonType::Decimal && type == JsonType::Decimal) {
+          column.mDecimals.push_back(mScratch.get_or_throw<double>());
+        } else if (column.mType == JsonType::Decimal && type == JsonType::Integer) {
+          column.mDecimals.push_back(static_cast<double>(mScratch.get_or_throw<int64_t>()));
+        } else {
+          return false;
+        }
+
+        column._push(true);
+
+        return true;
+      }
+
+  };
+
+  inline std::optional<Columns> parse_columns(std::string_view data) {
+    return ColumnReader{}.parse(data);
+  }
+
+  inline std::optional<Columns> parse_columns(std::string_view data, ColumnReader::schema_type const &schema) {
+    return ColumnReader{}.parse(data, schema);
+  }
+
+}
@@ -0,0 +1,326 @@
+#pragma once
+
+#include "jjson/stream.h"
+
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+
+#if defined(JJSON_WITH_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(JJSON_WITH_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace jjson {
+
+  // Compressed input and output through fixed-size buffers. The readers are
+  // DocumentStream readers that decompress the source on demand, so
+  // documents(gzip_reader(...)) or parse_stream(gzip_reader(...)) hold one
+  // chunk of compressed input and the current document at a time:
+  //
+  //   std::ifstream file{"data.json.gz", std::ios::binary};
+  //
+  //   for (auto &&document : documents(gzip_reader(file))) {
+  //   }
+  //
+  // The writers are stream buffers that compress what the serializer writes
+  // to them, block by block:
+  //
+  //   GzipWriter gzip{file};
+  //   std::ostream out{&gzip};
+  //
+  //   value.dump(out);
+  //   gzip.finish();
+  //
+  // Each codec is available when the library is built with it (JJSON_WITH_ZLIB
+  // and JJSON_WITH_ZSTD).
+
+  // Stream buffer that hands every full block of text to a compressor
+  class CompressedBuffer : public std::streambuf {
+
+    public:
+      CompressedBuffer(CompressedBuffer const &) = delete;
+      CompressedBuffer & operator = (CompressedBuffer const &) = delete;
+
+      // compresses the pending text and ends the compressed stream. Returns
+      // false if the compressor or the output failed.
+      bool finish() {
+        if (mFinished) {
+          return mOut.good();
+        }
+
+        mFinished = true;
+
+        return _flush(Flush::Finish) && mOut.flush().good();
+      }
+
+    protected:
+      enum class Flush {
+        None,
+        Sync,
+        Finish
+      };
+
+      std::ostream &mOut;
+      std::string mOutput;
+
+      CompressedBuffer(std::ostream &out, std::size_t bufferSize)
+        : mOut{out}, mOutput(std::max<std::size_t>(bufferSize, 1), '\0'), mInput(std::max<std::size_t>(bufferSize, 1), '\0') {
+        setp(mInput.data(), mInput.data() + mInput.size());
+      }
+
+      // compresses size bytes of data, writing the result to mOut through mOutput
+      virtual bool _compress(const char *data, std::size_t size, Flush flush) = 0;
+
+      int_type overflow(int_type c) override {
+        if (mFinished || !_flush(Flush::None)) {
+          return traits_type::eof();
+        }
+
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+          *pptr() = traits_type::to_char_type(c);
+          pbump(1);
+        }
+
+        return traits_type::not_eof(c);
+      }
+
+      int sync() override {
+        return !mFinished && _flush(Flush::Sync) && mOut.flush().good() ? 0 : -1;
+      }
+
+    private:
+      std::string mInput;
+      bool mFinished = false;
+
+      bool _flush(Flush flush) {
+        bool result = _compress(pbase(), static_cast<std::size_t>(pptr() - pbase()), flush);
+
+        setp(mInput.data(), mInput.data() + mInput.size());
+
+        return result && mOut.good();
+      }
+
+  };
+
+#if defined(JJSON_WITH_ZLIB)
+  // Inflates gzip or zlib data read from source. Concatenated gzip members
+  // are read as one stream.
+  inline DocumentStream::Reader gzip_reader(DocumentStream::Reader source, std::size_t bufferSize = DocumentStream::default_chunk_size) {
+    struct State {
+      z_stream stream{};
+      DocumentStream::Reader source;
+      std::string buffer;
+      bool boundary = true; // no member is partially read
+
+      ~State() {
+        inflateEnd(&stream);
+      }
+    };
+
+    auto state = std::make_shared<State>();
+
+    state->source = std::move(source);
+    state->buffer.resize(std::clamp<std::size_t>(bufferSize, 1, UINT_MAX));
+
+    if (inflateInit2(&state->stream, 15 + 32) != Z_OK) {
+      throw std::runtime_error("unable to initialize zlib");
+    }
+
+    return [state](char *data, std::size_t size) -> std::size_t {
+      auto &stream = state->stream;
+      auto limit = static_cast<uInt>(std::min<std::size_t>(size, UINT_MAX));
+
+      stream.next_out = reinterpret_cast<Bytef *>(data);
+      stream.avail_out = limit;
+
+      while (stream.avail_out == limit) {
+        if (stream.avail_in == 0) {
+          stream.next_in = reinterpret_cast<Bytef *>(state->buffer.data());
+          stream.avail_in = static_cast<uInt>(state->source(state->buffer.data(), state->buffer.size()));
+
+          if (stream.avail_in == 0) {
+            if (!state->boundary) {
+              throw std::runtime_error("truncated gzip stream");
+            }
+            return 0;
+          }
+        }
+
+        int result = inflate(&stream, Z_NO_FLUSH);
+
+        if (result == Z_STREAM_END) {
+          state->boundary = true;
+          inflateReset(&stream);
+        } else if (result == Z_OK) {
+          state->boundary = false;
+        } else {
+          throw std::runtime_error("invalid gzip stream");
+        }
+      }
+
+      return limit - stream.avail_out;
+    };
+  }
+
+  inline DocumentStream::Reader gzip_reader(std::istream &is, std::size_t bufferSize = DocumentStream::default_chunk_size) {
+    return gzip_reader(DocumentStream::reader(is), bufferSize);
+  }
+
+  // Writes a gzip member to out
+  class GzipWriter : public CompressedBuffer {
+
+    public:
+      explicit GzipWriter(std::ostream &out, int level = Z_DEFAULT_COMPRESSION, std::size_t bufferSize = DocumentStream::default_chunk_size)
+        : CompressedBuffer{out, std::min<std::size_t>(bufferSize, UINT_MAX)} {
+        if (deflateInit2(&mStream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+          throw std::runtime_error("unable to initialize zlib");
+        }
+      }
+
+      ~GzipWriter() override {
+        finish();
+        deflateEnd(&mStream);
+      }
+
+    protected:
+      bool _compress(const char *data, std::size_t size, Flush flush) override {
+        int mode = flush == Flush::Finish ? Z_FINISH : flush == Flush::Sync ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+        int result;
+
+        mStream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        mStream.avail_in = static_cast<uInt>(size);
+
+        do {
+          mStream.next_out = reinterpret_cast<Bytef *>(mOutput.data());
+          mStream.avail_out = static_cast<uInt>(mOutput.size());
+
+          result = deflate(&mStream, mode);
+
+          if (result == Z_STREAM_ERROR) {
+            return false;
+          }
+
+          mOut.write(mOutput.data(), static_cast<std::streamsize>(mOutput.size() - mStream.avail_out));
+        } while (mStream.avail_out == 0 || (mode == Z_FINISH && result != Z_STREAM_END));
+
+        return true;
+      }
+
+    private:
+      z_stream mStream{};
+
+  };
+#endif
+
+#if defined(JJSON_WITH_ZSTD)
+  // Decompresses zstd data read from source. Concatenated frames are read as
+  // one stream.
+  inline DocumentStream::Reader zstd_reader(DocumentStream::Reader source, std::size_t bufferSize = DocumentStream::default_chunk_size) {
+    struct State {
+      ZSTD_DCtx *context = nullptr;
+      DocumentStream::Reader source;
+      std::string buffer;
+      ZSTD_inBuffer input{nullptr, 0, 0};
+      bool boundary = true; // no frame is partially read
+
+      ~State() {
+        ZSTD_freeDCtx(context);
+      }
+    };
+
+    auto state = std::make_shared<State>();
+
+    state->source = std::move(source);
+    state->buffer.resize(std::max<std::size_t>(bufferSize, 1));
+
+    if ((state->context = ZSTD_createDCtx()) == nullptr) {
+      throw std::runtime_error("unable to initialize zstd");
+    }
+
+    return [state](char *data, std::size_t size) -> std::size_t {
+      auto &input = state->input;
+      ZSTD_outBuffer output{data, size, 0};
+
+      while (output.pos == 0) {
+        if (input.pos == input.size) {
+          input = {state->buffer.data(), state->source(state->buffer.data(), state->buffer.size()), 0};
+
+          if (input.size == 0) {
+            if (!state->boundary) {
+              throw std::runtime_error("truncated zstd stream");
+            }
+            return 0;
+          }
+        }
+
+        std::size_t result = ZSTD_decompressStream(state->context, &output, &input);
+
+        if (ZSTD_isError(result)) {
+          throw std::runtime_error("invalid zstd stream");
+        }
+
+        state->boundary = result == 0;
+      }
+
+      return output.pos;
+    };
+  }
+
+  inline DocumentStream::Reader zstd_reader(std::istream &is, std::size_t bufferSize = DocumentStream::default_chunk_size) {
+    return zstd_reader(DocumentStream::reader(is), bufferSize);
+  }
+
+  // Writes a zstd frame to out
+  class ZstdWriter : public CompressedBuffer {
+
+    public:
+      explicit ZstdWriter(std::ostream &out, int level = ZSTD_CLEVEL_DEFAULT, std::size_t bufferSize = DocumentStream::default_chunk_size)
+        : CompressedBuffer{out, bufferSize} {
+        if ((mContext = ZSTD_createCCtx()) == nullptr ||
+            ZSTD_isError(ZSTD_CCtx_setParameter(mContext, ZSTD_c_compressionLevel, level))) {
+          ZSTD_freeCCtx(mContext);
+          throw std::runtime_error("unable to initialize zstd");
+        }
+      }
+
+      ~ZstdWriter() override {
+        finish();
+        ZSTD_freeCCtx(mContext);
+      }
+
+    protected:
+      bool _compress(const char *data, std::size_t size, Flush flush) override {
+        auto mode = flush == Flush::Finish ? ZSTD_e_end : flush == Flush::Sync ? ZSTD_e_flush : ZSTD_e_continue;
+        ZSTD_inBuffer input{data, size, 0};
+        std::size_t remaining;
+
+        do {
+          ZSTD_outBuffer output{mOutput.data(), mOutput.size(), 0};
+
+          remaining = ZSTD_compressStream2(mContext, &output, &input, mode);
+
+          if (ZSTD_isError(remaining)) {
+            return false;
+          }
+
+          mOut.write(mOutput.data(), static_cast<std::streamsize>(output.pos));
+        } while (input.pos < input.size || (mode != ZSTD_e_continue && remaining != 0));
+
+        return true;
+      }
+
+    private:
+      ZSTD_CCtx *mContext = nullptr;
+
+  };
+#endif
+
+}
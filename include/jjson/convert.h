@@ -0,0 +1,156 @@
+#pragma once
+
+#include "jjson/json.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace jjson {
+
+  namespace detail {
+
+    // Runs body(begin, end) over [0, size) on up to threads workers. Each
+    // worker owns a contiguous range and takes grain-sized chunks from its
+    // front; once it runs dry it steals the back half of the largest range
+    // left, so uneven work keeps every worker busy without a shared queue.
+    template <typename Body>
+    void parallel_for(std::size_t size, std::size_t threads, std::size_t grain, Body const &body) {
+      threads = std::min(threads, (size + grain - 1)/grain);
+
+      if (threads <= 1) {
+        body(std::size_t{0}, size);
+        return;
+      }
+
+      struct alignas(64) Range {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+      };
+
+      std::vector<Range> ranges(threads);
+      std::exception_ptr error;
+      std::atomic_flag failed;
+
+      for (std::size_t i = 0; i < threads; i++) {
+        ranges[i].begin = size*i/threads;
+        ranges[i].end = size*(i + 1)/threads;
+      }
+
+      // moves the back half of the largest range of the other workers to self
+      auto steal = [&](std::size_t self) {
+        while (true) {
+          std::size_t victim = self;
+          std::size_t largest = 0;
+
+          for (std::size_t i = 0; i < threads; i++) {
+            std::lock_guard lock{ranges[i].mutex};
+
+            if (i != self && ranges[i].end - ranges[i].begin > largest) {
+              victim = i;
+              largest = ranges[i].end - ranges[i].begin;
+            }
+          }
+
+          if (largest == 0) {
+            return false;
+          }
+
+          std::size_t begin;
+          std::size_t end;
+
+          {
+            std::lock_guard lock{ranges[victim].mutex};
+            auto &range = ranges[victim];
+
+            // taken by someone else meanwhile
+            if (range.begin == range.end) {
+              continue;
+            }
+
+            end = range.end;
+            begin = range.end -= (range.end - range.begin + 1)/2;
+          }
+
+          std::lock_guard lock{ranges[self].mutex};
+
+          ranges[self].begin = begin;
+          ranges[self].end = end;
+
+          return true;
+        }
+      };
+
+      auto work = [&](std::size_t self) {
+        try {
+          while (!failed.test()) {
+            std::size_t begin;
+            std::size_t end;
+
+            {
+              std::lock_guard lock{ranges[self].mutex};
+              auto &range = ranges[self];
+
+              begin = range.begin;
+              end = range.begin = std::min(range.begin + grain, range.end);
+            }
+
+            if (begin < end) {
+              body(begin, end);
+            } else if (!steal(self)) {
+              break;
+            }
+          }
+        } catch (...) {
+          if (!failed.test_and_set()) {
+            error = std::current_exception();
+          }
+        }
+      };
+
+      {
+        std::vector<std::jthread> workers;
+
+        for (std::size_t i = 1; i < threads; i++) {
+          workers.emplace_back(work, i);
+        }
+
+        work(0);
+      }
+
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+
+  }
+
+  // Converts every value to T with get<T>(), across threads workers. The
+  // result is allocated once up front and result[i] is empty when values[i]
+  // doesn't convert, so one bad element doesn't fail the batch. Converters
+  // that return bool instead of throwing keep the whole batch free of
+  // exceptions:
+  //
+  //   bool json_to(Json const &value, MyType &out);
+  //
+  //   auto items = convert_all<MyType>(documents);
+  template <typename T>
+  std::vector<std::optional<T>> convert_all(std::span<Json const> values, std::size_t threads = std::thread::hardware_concurrency()) {
+    std::vector<std::optional<T>> result(values.size());
+
+    detail::parallel_for(values.size(), std::max<std::size_t>(threads, 1), 64, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; i++) {
+        result[i] = values[i].get<T>();
+      }
+    });
+
+    return result;
+  }
+
+}
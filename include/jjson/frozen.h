@@ -0,0 +1,433 @@
+#pragma once
+
+#include "jjson/json.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jjson {
+
+  // Immutable, read-optimized copy of a Json document created by freeze().
+  // Every node lives in one contiguous array (the children of a container are
+  // adjacent), strings and keys share a single blob and object members are
+  // placed by a minimal perfect hash, so a key lookup costs one hash, two
+  // table reads and one key compare.
+  //
+  // Nothing is modified after freeze(), so a FrozenJson and its values can be
+  // read from any number of threads concurrently without synchronization.
+  class FrozenJson {
+
+    struct Node {
+      JsonType type;
+      uint32_t size; // text length or number of children
+      uint64_t data; // scalar bits, blob offset or (first child | seeds << 32)
+    };
+
+    struct Key {
+      uint32_t offset;
+      uint32_t size;
+    };
+
+    struct Storage {
+      std::vector<Node> nodes;
+      std::vector<Key> keys; // parallel to nodes, used by object members
+      std::vector<uint32_t> seeds;
+      std::string blob;
+    };
+
+    public:
+      class Value {
+
+        public:
+          JsonType get_type() const {
+            return _node().type;
+          }
+
+          bool is_null() const {
+            return get_type() == JsonType::Null;
+          }
+
+          bool is_bool() const {
+            return get_type() == JsonType::Bool;
+          }
+
+          bool is_integer() const {
+            return get_type() == JsonType::Integer;
+          }
+
+          bool is_decimal() const {
+            return get_type() == JsonType::Decimal;
+          }
+
+          bool is_text() const {
+            return get_type() == JsonType::Text;
+          }
+
+          bool is_array() const {
+            return get_type() == JsonType::Array;
+          }
+
+          bool is_object() const {
+            return get_type() == JsonType::Object;
+          }
+
+          // number of elements/members
+          std::size_t size() const {
+            auto const &node = _node();
+            return (node.type == JsonType::Array || node.type == JsonType::Object) ? node.size : 0;
+          }
+
+          Value operator [] (std::size_t index) const {
+            if (index >= size()) {
+              throw std::runtime_error("invalid access");
+            }
+            return Value{mStorage, _first() + static_cast<uint32_t>(index)};
+          }
+
+          Value operator [] (std::string_view key) const {
+            if (auto value = find(key)) {
+              return *value;
+            }
+            throw std::runtime_error("invalid access");
+          }
+
+          std::optional<Value> find(std::string_view key) const {
+            auto const &node = _node();
+
+            if (node.type != JsonType::Object || node.size == 0) {
+              return {};
+            }
+
+            uint64_t hash = _hash(key);
+            uint32_t seed = mStorage->seeds[(node.data >> 32) + hash % _bucket_count(node.size)];
+            uint32_t index = _first() + static_cast<uint32_t>(_mix(hash, seed) % node.size);
+
+            if (_key(index) != key) {
+              return {};
+            }
+
+            return Value{mStorage, index};
+          }
+
+          bool has(std::string_view key) const {
+            return find(key).has_value();
+          }
+
+          // key of the index-th member of an object
+          std::string_view key(std::size_t index) const {
+            if (!is_object() || index >= size()) {
+              throw std::runtime_error("invalid access");
+            }
+            return _key(_first() + static_cast<uint32_t>(index));
+          }
+
+          template <typename T>
+          std::optional<T> get() const {
+            auto const &node = _node();
+
+            if constexpr (std::same_as<T, int> || std::same_as<T, int64_t>) {
+              if (node.type == JsonType::Integer) {
+                return static_cast<T>(std::bit_cast<int64_t>(node.data));
+              }
+            } else if constexpr (std::same_as<T, float> || std::same_as<T, double>) {
+              if (node.type == JsonType::Decimal) {
+                return static_cast<T>(std::bit_cast<double>(node.data));
+              }
+            } else if constexpr (std::same_as<T, bool>) {
+              if (node.type == JsonType::Bool) {
+                return node.data != 0;
+              }
+            } else if constexpr (std::same_as<T, std::nullptr_t>) {
+              if (node.type == JsonType::Null) {
+                return nullptr;
+              }
+            } else if constexpr (std::same_as<T, std::string_view> || std::same_as<T, std::string>) {
+              if (node.type == JsonType::Text) {
+                return T{mStorage->blob.data() + node.data, node.size};
+              }
+            } else {
+              return json().get<T>();
+            }
+            return {};
+          }
+
+          Json json() const {
+            auto const &node = _node();
+
+            switch (node.type) {
+              case JsonType::Null:
+                return Json{};
+              case JsonType::Bool:
+                return Json{node.data != 0};
+              case JsonType::Integer:
+                return Json{std::bit_cast<int64_t>(node.data)};
+              case JsonType::Decimal:
+                return Json{std::bit_cast<double>(node.data)};
+              case JsonType::Text:
+                return Json{*get<std::string>()};
+              case JsonType::Array: {
+                jArray result;
+                result.reserve(node.size);
+                for (std::size_t i = 0; i < node.size; i++) {
+                  result.push_back((*this)[i].json());
+                }
+                return Json{std::move(result)};
+              }
+              case JsonType::Object: {
+                jObject result;
+                result.reserve(node.size);
+                for (std::size_t i = 0; i < node.size; i++) {
+                  result.emplace(key(i), (*this)[i].json());
+                }
+                return Json{std::move(result)};
+              }
+            }
+            return Json{};
+          }
+
+          std::string dump() const {
+            return json().dump();
+          }
+
+        private:
+          friend class FrozenJson;
+
+          Storage const *mStorage;
+          uint32_t mIndex;
+
+          Value(Storage const *storage, uint32_t index)
+            : mStorage{storage}, mIndex{index} {
+          }
+
+          Node const & _node() const {
+            return mStorage->nodes[mIndex];
+          }
+
+          uint32_t _first() const {
+            return static_cast<uint32_t>(_node().data);
+          }
+
+          std::string_view _key(uint32_t index) const {
+            auto const &key = mStorage->keys[index];
+            return {mStorage->blob.data() + key.offset, key.size};
+          }
+
+      };
+
+      FrozenJson(FrozenJson &&) noexcept = default;
+      FrozenJson & operator = (FrozenJson &&) noexcept = default;
+
+      Value root() const {
+        return Value{mStorage.get(), 0};
+      }
+
+      Value operator [] (std::size_t index) const {
+        return root()[index];
+      }
+
+      Value operator [] (std::string_view key) const {
+        return root()[key];
+      }
+
+      // bytes used by the frozen layout
+      std::size_t size_bytes() const {
+        return mStorage->nodes.capacity()*sizeof(Node) + mStorage->keys.capacity()*sizeof(Key) +
+          mStorage->seeds.capacity()*sizeof(uint32_t) + mStorage->blob.capacity();
+      }
+
+      friend FrozenJson freeze(Json const &value);
+
+    private:
+      std::unique_ptr<Storage const> mStorage;
+
+      explicit FrozenJson(std::unique_ptr<Storage const> storage)
+        : mStorage{std::move(storage)} {
+      }
+
+      static uint64_t _hash(std::string_view key) {
+        return std::hash<std::string_view>{}(key);
+      }
+
+      static uint64_t _mix(uint64_t hash, uint32_t seed) {
+        // splitmix64 finalizer
+        uint64_t x = hash + (seed + 1)*0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27))*0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+      }
+
+      static uint32_t _bucket_count(uint32_t size) {
+        return (size + 1)/2;
+      }
+
+      static uint32_t _append(Storage &storage, std::string_view text) {
+        if (storage.blob.size() + text.size() > UINT32_MAX) {
+          throw std::length_error("frozen document is limited to 4GB of text");
+        }
+        auto offset = static_cast<uint32_t>(storage.blob.size());
+        storage.blob.append(text);
+        return offset;
+      }
+
+      // hash-and-displace: buckets are placed largest first, each one searching
+      // for a seed that sends all of its keys to free slots
+      static std::vector<uint32_t> _place(std::vector<uint64_t> const &hashes, std::vector<uint32_t> &seeds) {
+        auto n = static_cast<uint32_t>(hashes.size());
+        uint32_t bucketCount = _bucket_count(n);
+        std::vector<std::vector<uint32_t>> buckets(bucketCount);
+        std::vector<uint32_t> slots(n);
+        std::vector<bool> taken(n);
+        std::vector<uint32_t> order(bucketCount);
+        std::size_t seedsOffset = seeds.size();
+
+        seeds.resize(seeds.size() + bucketCount, 0);
+
+        for (uint32_t i = 0; i < n; i++) {
+          buckets[hashes[i] % bucketCount].push_back(i);
+        }
+
+        for (uint32_t i = 0; i < bucketCount; i++) {
+          order[i] = i;
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+          return buckets[a].size() > buckets[b].size();
+        });
+
+        std::vector<uint32_t> candidate;
+
+        for (uint32_t b : order) {
+          auto const &bucket = buckets[b];
+
+          if (bucket.empty()) {
+            break;
+          }
+
+          for (uint32_t seed = 0;; seed++) {
+            if (seed == (1u << 24)) {
+              throw std::runtime_error("unable to build the perfect hash");
+            }
+
+            candidate.clear();
+
+            for (uint32_t i : bucket) {
+              auto slot = static_cast<uint32_t>(_mix(hashes[i], seed) % n);
+
+              if (taken[slot] || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
+                break;
+              }
+
+              candidate.push_back(slot);
+            }
+
+            if (candidate.size() == bucket.size()) {
+              for (std::size_t i = 0; i < bucket.size(); i++) {
+                slots[bucket[i]] = candidate[i];
+                taken[candidate[i]] = true;
+              }
+              seeds[seedsOffset + b] = seed;
+              break;
+            }
+          }
+        }
+
+        return slots;
+      }
+
+  };
+
+  inline FrozenJson freeze(Json const &value) {
+    using Storage = FrozenJson::Storage;
+
+    auto storage = std::make_unique<Storage>();
+    // nodes are laid out breadth first: pending[i] is the source of nodes[i]
+    std::vector<Json const *> pending{&value};
+
+    storage->nodes.push_back({});
+    storage->keys.push_back({});
+
+    for (std::size_t i = 0; i < pending.size(); i++) {
+      Json const &source = *pending[i];
+      FrozenJson::Node node{source.get_type(), 0, 0};
+
+      switch (node.type) {
+        case JsonType::Null:
+          break;
+        case JsonType::Bool:
+          node.data = source.get_or_throw<bool>();
+          break;
+        case JsonType::Integer:
+        case JsonType::Decimal:
+          node.data = std::visit([](auto number) {
+            return std::bit_cast<uint64_t>(number);
+          }, number_value(source));
+          break;
+        case JsonType::Text: {
+          auto const &text = source.get_or_throw<std::string>();
+          node.size = static_cast<uint32_t>(text.size());
+          node.data = FrozenJson::_append(*storage, text);
+          break;
+        }
+        case JsonType::Array: {
+          auto const &array = source.get_or_throw<jArray>();
+          node.size = static_cast<uint32_t>(array.size());
+          node.data = pending.size();
+          for (auto const &item : array) {
+            pending.push_back(&item);
+            storage->nodes.push_back({});
+            storage->keys.push_back({});
+          }
+          break;
+        }
+        case JsonType::Object: {
+          auto const &object = source.get_or_throw<jObject>();
+          std::vector<uint64_t> hashes;
+          std::vector<std::pair<std::string const *, Json const *>> members;
+
+          hashes.reserve(object.size());
+          members.reserve(object.size());
+
+          for (auto const &[k, v] : object) {
+            hashes.push_back(FrozenJson::_hash(k));
+            members.emplace_back(&k, &v);
+          }
+
+          std::size_t first = pending.size();
+
+          node.size = static_cast<uint32_t>(object.size());
+          node.data = first | (static_cast<uint64_t>(storage->seeds.size()) << 32);
+
+          auto slots = FrozenJson::_place(hashes, storage->seeds);
+
+          pending.resize(first + members.size());
+          storage->nodes.resize(first + members.size());
+          storage->keys.resize(first + members.size());
+
+          for (std::size_t m = 0; m < members.size(); m++) {
+            auto const &key = *members[m].first;
+            pending[first + slots[m]] = members[m].second;
+            storage->keys[first + slots[m]] = {FrozenJson::_append(*storage, key), static_cast<uint32_t>(key.size())};
+          }
+          break;
+        }
+      }
+
+      if (pending.size() > UINT32_MAX) {
+        throw std::length_error("frozen document is limited to 4G nodes");
+      }
+
+      storage->nodes[i] = node;
+    }
+
+    return FrozenJson{std::move(storage)};
+  }
+
+}
@@ -0,0 +1,490 @@
+#pragma once
+
+#include "jjson/json.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace jjson {
+
+  // Byte range [begin, end) of a source
+  struct Span {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+
+    std::size_t size() const {
+      return end - begin;
+    }
+
+    bool operator == (Span const &) const = default;
+  };
+
+  // Source positions of the values of a document. The children of a node are
+  // the elements of an array, or the members of an object in source order
+  // (repeated keys included). Nodes are stored relative to their parent, so
+  // an edit only moves the nodes on its path and the siblings after them.
+  class SourceMap {
+
+    struct Entry {
+      std::size_t offset = 0; // of the value, from the begin of the parent value
+      std::size_t length = 0; // of the value
+      std::size_t key = 0; // from the begin of the key to the begin of the value
+      std::size_t keyLength = 0; // quotes included, 0 outside objects
+      std::vector<Entry> children;
+    };
+
+    public:
+      class Node {
+
+        public:
+          Span span() const {
+            std::size_t begin = mBase + mEntry->offset;
+            return {begin, begin + mEntry->length};
+          }
+
+          // key of an object member, quotes included
+          std::optional<Span> key() const {
+            if (mEntry->keyLength == 0) {
+              return {};
+            }
+
+            std::size_t begin = mBase + mEntry->offset - mEntry->key;
+
+            return Span{begin, begin + mEntry->keyLength};
+          }
+
+          // number of elements/members
+          std::size_t size() const {
+            return mEntry->children.size();
+          }
+
+          Node operator [] (std::size_t index) const {
+            if (index >= size()) {
+              throw std::runtime_error("invalid access");
+            }
+            return Node{&mEntry->children[index], mBase + mEntry->offset};
+          }
+
+        private:
+          friend class SourceMap;
+
+          Entry const *mEntry;
+          std::size_t mBase; // begin of the parent value
+
+          Node(Entry const *entry, std::size_t base)
+            : mEntry{entry}, mBase{base} {
+          }
+
+      };
+
+      // spans of the values of source. Only the structure is checked (strings
+      // are terminated, brackets balanced and members have a key), the
+      // values themselves are not validated.
+      static std::optional<SourceMap> parse(std::string_view source) {
+        SourceMap result;
+        ParseState ps{source.data(), source.data() + source.size()};
+
+        if (!_scan(ps, result.mRoot, source.data())) {
+          return {};
+        }
+
+        return result;
+      }
+
+      Node root() const {
+        return Node{&mRoot, 0};
+      }
+
+    private:
+      friend class SourceDocument;
+
+      Entry mRoot;
+
+      // the boundaries match the ones of Parser for every valid document:
+      // literals have a fixed length and numbers run up to a terminator
+      static bool _scan(ParseState &ps, Entry &entry, const char *parent) {
+        ps.skip_space();
+
+        const char *begin = ps.p;
+        int c = ps.peek();
+
+        entry.offset = static_cast<std::size_t>(begin - parent);
+        entry.children.clear();
+
+        if (c == '"') {
+          if (!ps.skip_string()) {
+            return false;
+          }
+        } else if (c == '[' || c == '{') {
+          ps.get();
+
+          if (!_scan_items(ps, entry.children, begin, c == '{', c == '[' ? ']' : '}')) {
+            return false;
+          }
+        } else if (c == 'n' || c == 't' || c == 'f') {
+          ps.p += std::min<std::ptrdiff_t>(c == 'f' ? 5 : 4, ps.end - ps.p);
+        } else {
+          while (ps.p < ps.end && *ps.p != ',' && *ps.p != ']' && *ps.p != '}' &&
+              !std::isspace(static_cast<unsigned char>(*ps.p))) {
+            ++ps.p;
+          }
+
+          if (ps.p == begin && c != -1) {
+            return false;
+          }
+        }
+
+        entry.length = static_cast<std::size_t>(ps.p - begin);
+
+        return true;
+      }
+
+      // scans the elements/members up to close, or to the end of ps when
+      // close is -1
+      static bool _scan_items(ParseState &ps, std::vector<Entry> &children, const char *parent, bool members, int close) {
+        while (true) {
+          ps.skip_space();
+
+          int c = ps.peek();
+
+          if (c == close) {
+            ps.get();
+            return true;
+          }
+
+          if (c == ',') {
+            ps.get();
+            continue;
+          }
+
+          if (c == -1 || c == ']' || c == '}') {
+            return false;
+          }
+
+          auto &child = children.emplace_back();
+
+          if (!members) {
+            if (!_scan(ps, child, parent)) {
+              return false;
+            }
+            continue;
+          }
+
+          const char *key = ps.p;
+
+          if (c != '"' || !ps.skip_string()) {
+            return false;
+          }
+
+          auto keyLength = static_cast<std::size_t>(ps.p - key);
+
+          ps.skip_space();
+
+          if (ps.get() != ':') {
+            return false;
+          }
+
+          ps.skip_space();
+
+          if (ps.peek() == -1 || !_scan(ps, child, parent)) {
+            return false;
+          }
+
+          child.key = static_cast<std::size_t>(parent + child.offset - key);
+          child.keyLength = keyLength;
+        }
+      }
+
+  };
+
+  // A document kept with its source and spans, so that an edit of the text
+  // re-parses only the members of the innermost array or object enclosing
+  // it that the edit touches. Every other value is kept as it is, so an edit
+  // costs time in proportion to its size rather than to the document:
+  //
+  //   auto document = SourceDocument::parse(text).value();
+  //
+  //   document.edit(offset, 2, "42");
+  //   document.json()["items"][3];
+  //
+  // Edits that change the structure around them (unbalancing brackets or
+  // quotes, or repeating a key) fall back to parsing the whole source.
+  class SourceDocument {
+
+    using Entry = SourceMap::Entry;
+
+    public:
+      static std::optional<SourceDocument> parse(std::string source, NumberMode numbers = NumberMode::Convert) {
+        SourceDocument result{numbers};
+
+        result.mSource = std::move(source);
+
+        if (!result._parse_all()) {
+          return {};
+        }
+
+        return result;
+      }
+
+      Json const & json() const {
+        return mJson;
+      }
+
+      std::string const & source() const {
+        return mSource;
+      }
+
+      SourceMap const & spans() const {
+        return mSpans;
+      }
+
+      // replaces length bytes at offset with text. Returns false, leaving the
+      // document unchanged, if the range is out of the source or the new
+      // source is not a valid document (then error() tells why).
+      bool edit(std::size_t offset, std::size_t length, std::string_view text) {
+        if (offset > mSource.size() || length > mSource.size() - offset) {
+          return false;
+        }
+
+        auto path = _enclosing(offset, offset + length);
+
+        if (!path.empty() && _reparse(path, offset, offset + length, text)) {
+          return true;
+        }
+
+        std::string removed = mSource.substr(offset, length);
+
+        mSource.replace(offset, length, text);
+
+        if (!_parse_all()) {
+          mSource.replace(offset, text.size(), removed);
+          return false;
+        }
+
+        return true;
+      }
+
+      // error of the last failed parse or edit
+      ParseError const & error() const {
+        return mParser.error();
+      }
+
+    private:
+      // a container enclosing the edit, and the child on the way to the next
+      struct Level {
+        Entry *entry;
+        Json *value;
+        std::size_t begin;
+        std::size_t index = 0;
+      };
+
+      std::string mSource;
+      Json mJson;
+      SourceMap mSpans;
+      Parser mParser;
+
+      explicit SourceDocument(NumberMode numbers)
+        : mParser{numbers} {
+      }
+
+      bool _parse_all() {
+        Json value;
+
+        if (!mParser.parse_into(mSource, value)) {
+          return false;
+        }
+
+        auto spans = SourceMap::parse(mSource);
+
+        if (!spans) {
+          return false;
+        }
+
+        mJson = std::move(value);
+        mSpans = std::move(*spans);
+
+        return true;
+      }
+
+      std::string _key(std::size_t position) const {
+        std::string key;
+        ParseState ps{mSource.data() + position, mSource.data() + mSource.size()};
+
+        ps.read_string(key);
+
+        return key;
+      }
+
+      // containers whose brackets enclose [offset, end), outermost first
+      std::vector<Level> _enclosing(std::size_t offset, std::size_t end) {
+        std::vector<Level> path;
+        Entry *entry = &mSpans.mRoot;
+        Json *value = &mJson;
+        std::size_t begin = entry->offset;
+
+        while ((value->is_array() || value->is_object()) && begin < offset && end < begin + entry->length) {
+          auto &children = entry->children;
+
+          path.push_back({entry, value, begin});
+
+          // the last child starting before the edit is the only one that
+          // can enclose it
+          auto i = std::partition_point(children.begin(), children.end(), [&](Entry const &child) {
+            return begin + child.offset < offset;
+          });
+
+          if (i == children.begin() || end >= begin + (i - 1)->offset + (i - 1)->length) {
+            break;
+          }
+
+          auto index = static_cast<std::size_t>(i - 1 - children.begin());
+          auto &child = children[index];
+
+          if (value->is_array()) {
+            value = &(*value)[index];
+          } else {
+            auto &object = value->get_or_throw<jObject>();
+            auto member = object.find(_key(begin + child.offset - child.key));
+
+            // with repeated keys the members don't match the spans
+            if (object.size() != children.size() || member == object.end()) {
+              break;
+            }
+
+            value = &member->second;
+          }
+
+          path.back().index = index;
+          entry = &child;
+          begin += child.offset;
+        }
+
+        return path;
+      }
+
+      // re-parses the children of the innermost container that touch the
+      // edit, along with the separators around them. Nothing is changed
+      // unless the result is valid.
+      bool _reparse(std::vector<Level> const &path, std::size_t offset, std::size_t end, std::string_view text) {
+        auto [entry, value, begin, index] = path.back();
+        auto &children = entry->children;
+        bool members = value->is_object();
+
+        auto first = std::partition_point(children.begin(), children.end(), [&](Entry const &child) {
+          return begin + child.offset + child.length < offset;
+        });
+        auto last = std::partition_point(first, children.end(), [&](Entry const &child) {
+          return begin + child.offset - child.key <= end;
+        });
+
+        std::size_t from = first != children.begin() ? begin + (first - 1)->offset + (first - 1)->length : begin + 1;
+        std::size_t to = last != children.end() ? begin + last->offset - last->key : begin + entry->length - 1;
+
+        std::string region;
+
+        region.reserve(to - from + text.size());
+        region.append(mSource, from, offset - from).append(text).append(mSource, end, to - end);
+
+        std::vector<Entry> added;
+        ParseState ps{region.data(), region.data() + region.size()};
+
+        if (!SourceMap::_scan_items(ps, added, region.data(), members, -1)) {
+          return false;
+        }
+
+        std::vector<Json> values(added.size());
+        std::vector<std::string> keys;
+
+        for (std::size_t i = 0; i < added.size(); i++) {
+          auto &child = added[i];
+
+          if (!mParser.parse_into(std::string_view{region}.substr(child.offset, child.length), values[i])) {
+            return false;
+          }
+
+          if (members) {
+            ParseState key{region.data() + child.offset - child.key, region.data() + region.size()};
+
+            if (!key.read_string(keys.emplace_back()) || keys.back().empty()) {
+              return false;
+            }
+          }
+
+          child.offset += from - begin;
+        }
+
+        if (members) {
+          auto &object = value->get_or_throw<jObject>();
+          std::unordered_set<std::string> removed;
+
+          for (auto i = first; i != last; ++i) {
+            removed.insert(_key(begin + i->offset - i->key));
+          }
+
+          // a repeated key leaves a member without a value, which only the
+          // full parse resolves
+          std::unordered_set<std::string_view> seen;
+
+          for (auto const &key : keys) {
+            if (!seen.insert(key).second || (object.contains(key) && !removed.contains(key))) {
+              return false;
+            }
+          }
+
+          if (object.size() != children.size()) {
+            return false;
+          }
+
+          for (auto const &key : removed) {
+            object.erase(key);
+          }
+
+          for (std::size_t i = 0; i < keys.size(); i++) {
+            object.insert_or_assign(std::move(keys[i]), std::move(values[i]));
+          }
+        } else {
+          auto &array = value->get_or_throw<jArray>();
+          auto position = array.begin() + (first - children.begin());
+
+          position = array.erase(position, position + (last - first));
+          array.insert(position, std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+        }
+
+        // the spans after the edit move by the change in length
+        auto shift = [&](std::size_t &position) {
+          position = position + text.size() - (end - offset);
+        };
+
+        auto next = children.insert(children.erase(first, last), std::make_move_iterator(added.begin()), std::make_move_iterator(added.end()));
+
+        for (next += static_cast<std::ptrdiff_t>(added.size()); next != children.end(); ++next) {
+          shift(next->offset);
+        }
+
+        for (std::size_t k = path.size(); k-- > 0;) {
+          shift(path[k].entry->length);
+
+          if (k > 0) {
+            auto &siblings = path[k - 1].entry->children;
+
+            for (std::size_t i = path[k - 1].index + 1; i < siblings.size(); i++) {
+              shift(siblings[i].offset);
+            }
+          }
+        }
+
+        mSource.replace(offset, end - offset, text);
+
+        return true;
+      }
+
+  };
+
+}
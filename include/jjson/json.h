@@ -6,8 +6,10 @@
 #include <string_view>
 #include <map>
 #include <optional>
+#include <expected>
 #include <charconv>
 #include <cctype>
+#include <cstring>
 #include <cmath>
 #include <algorithm>
 #include <sstream>
@@ -15,9 +17,30 @@
 #include <istream>
 #include <iterator>
 #include <unordered_map>
+#include <bit>
+#include <cstdint>
+#include <concepts>
+#include <utility>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace jjson {
-  class Json;
+  struct JsonTraits;
+
+  template <typename Traits>
+  class BasicJson;
+
+  template <typename Traits>
+  class BasicParser;
+
+  using Json = BasicJson<JsonTraits>;
+  using Parser = BasicParser<JsonTraits>;
 }
 
 namespace jjson {
@@ -32,31 +55,260 @@ namespace jjson {
     Object
   };
 
-  class Json;
+  // Storage types of a BasicJson. The containers are templates over the
+  // value type and bring their allocator along, so a traits type can pick
+  // std::pmr containers, flat or fixed-capacity maps and narrower numbers:
+  //
+  //   struct SmallTraits {
+  //     using integer_type = int32_t;
+  //     using decimal_type = float;
+  //     using text_type = std::pmr::string;
+  //
+  //     template <typename Value>
+  //     using array_type = std::pmr::vector<Value>;
+  //
+  //     template <typename Value>
+  //     using object_type = flat_map<std::pmr::string, Value>;
+  //   };
+  //
+  // Arrays are vector-like. Objects are maps keyed by text_type with find(),
+  // contains(), try_emplace() and pair iteration; node handles (extract())
+  // let a parser recycle members and buckets are reported by memory_usage()
+  // when the map has them. Numbers that don't fit integer_type fail to parse.
+  struct JsonTraits {
+    using integer_type = int64_t;
+    using decimal_type = double;
+    using text_type = std::string;
+
+    template <typename Value>
+    using array_type = std::vector<Value>;
+
+    template <typename Value>
+    using object_type = std::unordered_map<std::string, Value>;
+  };
+
+  // Number kept as the text it was parsed from, by a Parser in
+  // NumberMode::Raw. Nothing is converted while parsing; get<T>() converts
+  // on access and exact() gives the value as decimal digits and a power of
+  // ten of any size, so integers beyond 64 bits and long decimals are never
+  // rounded. dump() writes the original text.
+  class RawNumber {
+
+    public:
+      // (-1)^negative * digits * 10^exponent, without leading or trailing
+      // zeros in digits (empty for zero)
+      struct Decimal {
+        bool negative = false;
+        std::string digits;
+        int64_t exponent = 0;
 
-  using jArray = std::vector<Json>;
-  using jObject = std::unordered_map<std::string, Json>;
-  using jValue = std::variant<std::nullptr_t, bool, int64_t, double, std::string, jArray, jObject>;
+        bool operator == (Decimal const &) const = default;
+      };
 
-  template <typename T>
+      RawNumber() = default;
+
+      // text must be a whole number in the syntax accepted by Parser
+      static std::optional<RawNumber> parse(std::string_view text);
+
+      // Integer or Decimal, as the number would be converted by Parser
+      JsonType type() const {
+        return mType;
+      }
+
+      std::string_view text() const {
+        return mText;
+      }
+
+      Decimal exact() const {
+        Decimal result;
+        std::string_view text = mText;
+        int base = 10;
+
+        if (!text.empty() && text.front() == '-') {
+          result.negative = true;
+          text.remove_prefix(1);
+        }
+
+        if (text.size() > 1 && text[0] == '0') {
+          char c = static_cast<char>(std::tolower(static_cast<unsigned char>(text[1])));
+
+          if (c == 'x' || c == 'b') {
+            base = c == 'x' ? 16 : 2;
+            text.remove_prefix(2);
+          } else if (c != '.') {
+            base = 8;
+          }
+        }
+
+        auto &digits = result.digits;
+
+        if (base != 10) {
+          // schoolbook conversion, digits holds the decimal digit values
+          for (char c : text) {
+            int carry = std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : std::tolower(static_cast<unsigned char>(c)) - 'a' + 10;
+
+            for (auto i = digits.rbegin(); i != digits.rend(); i++) {
+              int value = *i*base + carry;
+              *i = static_cast<char>(value % 10);
+              carry = value/10;
+            }
+
+            for (; carry > 0; carry /= 10) {
+              digits.insert(digits.begin(), static_cast<char>(carry % 10));
+            }
+          }
+
+          for (auto &c : digits) {
+            c = static_cast<char>(c + '0');
+          }
+        } else {
+          bool fraction = false;
+
+          for (std::size_t i = 0; i < text.size(); i++) {
+            char c = text[i];
+
+            if (c == '.') {
+              fraction = true;
+            } else if (c == 'e' || c == 'E') {
+              int64_t exponent = 0;
+              auto tail = text.substr(i + 1 + (i + 1 < text.size() && text[i + 1] == '+'));
+              auto [end, ec] = std::from_chars(tail.data(), tail.data() + tail.size(), exponent);
+
+              if (ec == std::errc::result_out_of_range) {
+                exponent = tail.front() == '-' ? INT64_MIN/2 : INT64_MAX/2;
+              }
+
+              result.exponent += exponent;
+              break;
+            } else {
+              if (!digits.empty() || c != '0') {
+                digits += c;
+              }
+
+              if (fraction) {
+                result.exponent--;
+              }
+            }
+          }
+        }
+
+        while (!digits.empty() && digits.back() == '0') {
+          digits.pop_back();
+          result.exponent++;
+        }
+
+        if (digits.empty()) {
+          result = Decimal{};
+        }
+
+        return result;
+      }
+
+      // exact conversion: integers only convert to integral types they fit
+      // in, decimals only to floating point types (rounded as by Parser)
+      template <typename T>
+        requires std::integral<T> || std::floating_point<T>
+      std::optional<T> get() const {
+        if constexpr (std::floating_point<T>) {
+          if (mType != JsonType::Decimal) {
+            return {};
+          }
+
+          if (auto value = _decimal()) {
+            return static_cast<T>(*value);
+          }
+
+          return {};
+        } else {
+          if (mType != JsonType::Integer) {
+            return {};
+          }
+
+          auto value = exact();
+          uint64_t magnitude = 0;
+
+          for (char c : value.digits) {
+            if (magnitude > (UINT64_MAX - (c - '0'))/10) {
+              return {};
+            }
+            magnitude = magnitude*10 + (c - '0');
+          }
+
+          for (int64_t i = 0; i < value.exponent; i++) {
+            if (magnitude > UINT64_MAX/10) {
+              return {};
+            }
+            magnitude *= 10;
+          }
+
+          if (!value.negative) {
+            return std::in_range<T>(magnitude) ? std::optional<T>{static_cast<T>(magnitude)} : std::nullopt;
+          }
+
+          if (magnitude > static_cast<uint64_t>(INT64_MAX) + 1) {
+            return {};
+          }
+
+          auto negative = static_cast<int64_t>(0 - magnitude);
+
+          return std::in_range<T>(negative) ? std::optional<T>{static_cast<T>(negative)} : std::nullopt;
+        }
+      }
+
+      // value to compare with, for decimals and integers alike
+      double to_double() const {
+        if (mType == JsonType::Decimal) {
+          return _decimal().value_or(0.0);
+        }
+
+        auto value = exact();
+        double result = 0.0;
+
+        std::from_chars(value.digits.data(), value.digits.data() + value.digits.size(), result);
+
+        result *= std::pow(10.0, static_cast<double>(value.exponent));
+
+        return value.negative ? -result : result;
+      }
+
+      friend bool operator == (RawNumber const &lhs, RawNumber const &rhs) {
+        return lhs.mType == rhs.mType && (lhs.mText == rhs.mText || lhs.exact() == rhs.exact());
+      }
+
+    private:
+      template <typename Traits>
+      friend class BasicParser;
+
+      template <typename Traits>
+      friend class BasicJson;
+
+      std::string mText;
+      JsonType mType = JsonType::Integer;
+
+      std::optional<double> _decimal() const;
+
+  };
+
+  template <typename T, typename Value = Json>
   concept JsonTypeConcept =
     std::same_as<T, std::nullptr_t> ||
     std::same_as<T, bool> ||
-    std::convertible_to<T, int64_t> ||
-    std::convertible_to<T, double> ||
-    std::convertible_to<T, std::string> ||
-    std::same_as<T, jArray> ||
-    std::same_as<T, jObject>;
+    std::convertible_to<T, typename Value::integer_type> ||
+    std::convertible_to<T, typename Value::decimal_type> ||
+    std::convertible_to<T, typename Value::text_type> ||
+    std::same_as<T, typename Value::array_type> ||
+    std::same_as<T, typename Value::object_type> ||
+    std::same_as<T, RawNumber>;
 
   struct ParseState {
     const char *p;
     const char *end;
 
-    int peek() const {
+    constexpr int peek() const {
       return p < end ? static_cast<unsigned char>(*p) : -1;
     }
 
-    int get() {
+    constexpr int get() {
       return p < end ? static_cast<unsigned char>(*p++) : -1;
     }
 
@@ -65,57 +317,431 @@ namespace jjson {
         ++p;
       }
     }
+
+    // reads a string, decoding escapes and validating UTF-8. Runs without
+    // quotes, backslashes or non-ASCII bytes are found 16 bytes at a time and
+    // copied in bulk.
+    template <typename String>
+    constexpr bool read_string(String &out) {
+      ++p; // skip leading '"'
+
+      while (true) {
+        const char *run = p;
+
+        p = _find_special(p, end);
+        out.append(run, p);
+
+        if (p >= end) {
+          return false;
+        }
+
+        if (*p == '"') {
+          ++p;
+          return true;
+        }
+
+        if (*p == '\\') {
+          if (!_read_escape(out)) {
+            return false;
+          }
+        } else {
+          std::size_t n = _utf8_length(p, end);
+
+          if (n == 0) {
+            return false;
+          }
+
+          out.append(p, n);
+          p += n;
+        }
+      }
+    }
+
+    // moves past a string without decoding it
+    bool skip_string() {
+      const char *begin = ++p; // skip leading '"'
+
+      while (p < end) {
+        auto *quote = static_cast<const char *>(std::memchr(p, '"', end - p));
+
+        if (quote == nullptr) {
+          break;
+        }
+
+        // the quote is escaped if preceded by an odd number of backslashes
+        const char *slash = quote;
+
+        while (slash > begin && slash[-1] == '\\') {
+          --slash;
+        }
+
+        p = quote + 1;
+
+        if ((quote - slash) % 2 == 0) {
+          return true;
+        }
+      }
+
+      p = end;
+
+      return false;
+    }
+
+    // moves past the next value without building it. Brackets must match
+    // and literals and numbers must be well formed, but strings are only
+    // checked for their closing quote and separators are not checked, so
+    // [1 2] or {"a"} inside a skipped value go unnoticed.
+    bool skip_value();
+
+    // first '"', '\\' or non-ASCII byte in [p, end)
+    static constexpr const char * _find_special(const char *p, const char *end) {
+      // the vector scans can't run in constant evaluation
+      if !consteval {
+#if defined(__SSE2__)
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i slash = _mm_set1_epi8('\\');
+
+        while (end - p >= 16) {
+          __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+          // movemask of the chunk itself flags the bytes with the high bit set
+          auto mask = static_cast<unsigned>(
+              _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, slash))) |
+              _mm_movemask_epi8(chunk));
+
+          if (mask != 0) {
+            return p + std::countr_zero(mask);
+          }
+
+          p += 16;
+        }
+#else
+        if constexpr (std::endian::native == std::endian::little) {
+          constexpr uint64_t ones = 0x0101010101010101ull;
+          constexpr uint64_t highs = 0x8080808080808080ull;
+
+          auto zero = [](uint64_t v) {
+            return (v - ones) & ~v & highs;
+          };
+
+          while (end - p >= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+
+            uint64_t mask = zero(word ^ (ones*'"')) | zero(word ^ (ones*'\\')) | (word & highs);
+
+            if (mask != 0) {
+              return p + std::countr_zero(mask)/8;
+            }
+
+            p += 8;
+          }
+        }
+#endif
+      }
+
+      while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) < 0x80) {
+        ++p;
+      }
+
+      return p;
+    }
+
+    // length of the UTF-8 sequence at p, or 0 if it is malformed
+    static constexpr std::size_t _utf8_length(const char *p, const char *end) {
+      auto byte = [&](std::size_t i) {
+        return p + i < end ? static_cast<unsigned char>(p[i]) : 0u;
+      };
+
+      auto between = [](unsigned c, unsigned lo, unsigned hi) {
+        return c >= lo && c <= hi;
+      };
+
+      unsigned c0 = byte(0);
+
+      if (c0 < 0x80) {
+        return 1;
+      }
+
+      if (between(c0, 0xc2, 0xdf)) {
+        return between(byte(1), 0x80, 0xbf) ? 2 : 0;
+      }
+
+      if (between(c0, 0xe0, 0xef)) {
+        unsigned lo = c0 == 0xe0 ? 0xa0 : 0x80; // overlong
+        unsigned hi = c0 == 0xed ? 0x9f : 0xbf; // surrogates
+        return between(byte(1), lo, hi) && between(byte(2), 0x80, 0xbf) ? 3 : 0;
+      }
+
+      if (between(c0, 0xf0, 0xf4)) {
+        unsigned lo = c0 == 0xf0 ? 0x90 : 0x80; // overlong
+        unsigned hi = c0 == 0xf4 ? 0x8f : 0xbf; // above U+10FFFF
+        return between(byte(1), lo, hi) && between(byte(2), 0x80, 0xbf) && between(byte(3), 0x80, 0xbf) ? 4 : 0;
+      }
+
+      return 0;
+    }
+
+    constexpr bool _read_hex4(uint32_t &value) {
+      if (end - p < 4) {
+        return false;
+      }
+
+      value = 0;
+
+      for (int i = 0; i < 4; i++) {
+        int c = *p++;
+
+        value <<= 4;
+
+        if (c >= '0' && c <= '9') {
+          value |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+          value |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+          value |= c - 'A' + 10;
+        } else {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    template <typename String>
+    constexpr bool _read_escape(String &out) {
+      ++p; // skip '\\'
+
+      switch (get()) {
+        case '"': out += '"'; return true;
+        case '\\': out += '\\'; return true;
+        case '/': out += '/'; return true;
+        case 'b': out += '\b'; return true;
+        case 'f': out += '\f'; return true;
+        case 'n': out += '\n'; return true;
+        case 'r': out += '\r'; return true;
+        case 't': out += '\t'; return true;
+        case 'u': break;
+        default: return false;
+      }
+
+      uint32_t code;
+
+      if (!_read_hex4(code)) {
+        return false;
+      }
+
+      if (code >= 0xdc00 && code <= 0xdfff) {
+        return false; // lone low surrogate
+      }
+
+      if (code >= 0xd800 && code <= 0xdbff) {
+        uint32_t low;
+
+        if (end - p < 2 || p[0] != '\\' || p[1] != 'u') {
+          return false;
+        }
+
+        p += 2;
+
+        if (!_read_hex4(low) || low < 0xdc00 || low > 0xdfff) {
+          return false;
+        }
+
+        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+      }
+
+      if (code < 0x80) {
+        out += static_cast<char>(code);
+      } else if (code < 0x800) {
+        out += static_cast<char>(0xc0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+      } else if (code < 0x10000) {
+        out += static_cast<char>(0xe0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+      } else {
+        out += static_cast<char>(0xf0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (code & 0x3f));
+      }
+
+      return true;
+    }
   };
 
-  class Json {
+  enum class ParseErrorKind {
+    UnexpectedEnd, // the input ended inside a value
+    UnexpectedCharacter, // no value starts with this character
+    InvalidLiteral, // misspelled null, true or false
+    InvalidNumber,
+    InvalidString, // unknown escape or malformed UTF-8
+    InvalidKey, // object key missing or empty
+    ExpectedColon,
+    Rejected // a parse filter rejected the value
+  };
+
+  struct ParseError {
+    ParseErrorKind kind = ParseErrorKind::UnexpectedEnd;
+    std::size_t offset = 0; // bytes from the start of the input
+    std::size_t line = 1;
+    std::size_t column = 1; // in bytes
+
+    bool operator == (ParseError const &) const = default;
+  };
+
+  // A parse filter is consulted while the document is scanned, so a payload
+  // can be rejected (or trimmed) before it is fully materialized:
+  //   begin(type)    before an array, object or text is read
+  //   end(value)     after any value is complete
+  //   member(key)    filter for the value of an object member
+  //   element(index) filter for an array element
+  // Returning false from begin/end aborts the parse. A filter may also provide
+  // skip(): members/elements whose filter returns true are stepped over
+  // without being materialized.
+  template <typename T, typename Value = Json>
+  concept ParseFilterConcept = requires (T const &filter, JsonType type, Value const &value, typename Value::text_type const &key, std::size_t index) {
+    { filter.begin(type) } -> std::convertible_to<bool>;
+    { filter.end(value) } -> std::convertible_to<bool>;
+    { filter.member(key) } -> std::convertible_to<T>;
+    { filter.element(index) } -> std::convertible_to<T>;
+  };
+
+  // accepts everything
+  struct ParseFilter {
+    constexpr bool begin(JsonType) const {
+      return true;
+    }
+
+    template <typename Value>
+    constexpr bool end(Value const &) const {
+      return true;
+    }
+
+    template <typename Key>
+    constexpr ParseFilter member(Key const &) const {
+      return {};
+    }
+
+    constexpr ParseFilter element(std::size_t) const {
+      return {};
+    }
+  };
+
+  // Heap bytes owned by a Json tree, as reported by Json::memory_usage().
+  // Object members are counted with the node layout of the common standard
+  // libraries (link, cached hash, key and value).
+  struct MemoryUsage {
+    std::size_t strings = 0; // buffers of texts, keys and raw numbers
+    std::size_t arrays = 0; // element buffers, including unused capacity
+    std::size_t objects = 0; // member nodes
+    std::size_t buckets = 0; // bucket arrays of objects
+    std::size_t nodes = 0; // part of arrays and objects taken by the Json values themselves
+    std::size_t slack = 0; // unused capacity of strings and arrays, released by shrink_to_fit()
+
+    std::size_t total() const {
+      return strings + arrays + objects + buckets;
+    }
+
+    bool operator == (MemoryUsage const &) const = default;
+  };
+
+  // JSON value whose storage types come from Traits (see JsonTraits). Json is
+  // the instantiation with the default traits.
+  template <typename Traits>
+  class BasicJson {
+
+    // the names used by the members, bound to this instantiation
+    using Json = BasicJson;
+    using jArray = typename Traits::template array_type<BasicJson>;
+    using jObject = typename Traits::template object_type<BasicJson>;
+    using jValue = std::variant<std::nullptr_t, bool, typename Traits::integer_type, typename Traits::decimal_type, typename Traits::text_type, jArray, jObject, RawNumber>;
 
     public:
+      using traits_type = Traits;
       using null_type = std::nullptr_t;
       using bool_type = bool;
-      using integer_type = int64_t;
-      using decimal_type = double;
-      using text_type = std::string;
+      using integer_type = typename Traits::integer_type;
+      using decimal_type = typename Traits::decimal_type;
+      using text_type = typename Traits::text_type;
       using array_type = jArray;
       using object_type = jObject;
+      using variant_type = jValue;
 
       static std::optional<Json> parse(std::string_view data) {
-        ParseState ps{data.data(), data.data() + data.size()};
-        return _parse(ps);
+        return BasicParser<Traits>{}.parse(data);
+      }
+
+      // like parse(), telling where and why the input is invalid
+      static std::expected<Json, ParseError> try_parse(std::string_view data) {
+        return BasicParser<Traits>{}.try_parse(data);
+      }
+
+      template <ParseFilterConcept<Json> Filter>
+      static std::expected<Json, ParseError> try_parse(std::string_view data, Filter const &filter) {
+        return BasicParser<Traits>{}.try_parse(data, filter);
       }
 
       static std::optional<Json> parse(std::istream &is) {
+        return parse(is, ParseFilter{});
+      }
+
+      template <ParseFilterConcept<Json> Filter>
+      static std::optional<Json> parse(std::string_view data, Filter const &filter) {
+        return BasicParser<Traits>{}.parse(data, filter);
+      }
+
+      template <ParseFilterConcept<Json> Filter>
+      static std::optional<Json> parse(std::istream &is, Filter const &filter) {
         std::string data(std::istreambuf_iterator<char>(is), {});
-        return parse(std::string_view(data));
+        return parse(std::string_view(data), filter);
+      }
+
+      // objects owning a filter (Schema, Projection, ...) expose it by filter()
+      template <typename T>
+        requires requires (T const &source) {
+          { source.filter() } -> ParseFilterConcept<Json>;
+        }
+      static std::optional<Json> parse(std::string_view data, T const &source) {
+        return parse(data, source.filter());
+      }
+
+      template <typename T>
+        requires requires (T const &source) {
+          { source.filter() } -> ParseFilterConcept<Json>;
+        }
+      static std::optional<Json> parse(std::istream &is, T const &source) {
+        return parse(is, source.filter());
       }
 
-      Json()
+      BasicJson()
         : Json{nullptr} {
       }
 
-      template <JsonTypeConcept T>
-      Json(T const &value)
+      template <JsonTypeConcept<Json> T>
+      BasicJson(T const &value)
         : mValue{value} {
       }
 
-      template <JsonTypeConcept T>
-      Json(T &&value)
+      template <JsonTypeConcept<Json> T>
+      BasicJson(T &&value)
         : mValue{std::move(value)} {
       }
 
-      template <JsonTypeConcept ...Args>
-      Json(Args &&...args)
+      template <JsonTypeConcept<Json> ...Args>
+      BasicJson(Args &&...args)
         : mValue{jArray{std::move(args)...}} {
       }
 
-      Json(Json const &value)
+      BasicJson(Json const &value)
         : mValue{value.mValue} {
       }
 
-      Json(Json &&value)
+      BasicJson(Json &&value) noexcept(std::is_nothrow_move_constructible_v<decltype(mValue)>)
         : mValue{std::move(value.mValue)} {
       }
 
-      Json(std::initializer_list<std::pair<std::string, Json>> const &value)
+      BasicJson(std::initializer_list<std::pair<text_type, Json>> const &value)
         : Json{jObject{value.begin(), value.end()}} {
       }
 
@@ -123,7 +749,7 @@ namespace jjson {
         requires requires (Json &out, T const &value) {
           { json_from(out, value) };
         }
-      Json(T const &t)
+      BasicJson(T const &t)
         : Json{}
       {
         json_from(*this, t);
@@ -133,7 +759,7 @@ namespace jjson {
         requires requires (Json &out, T const &value) {
           { json_from(out, value) };
         }
-      Json(Container<T> const &values)
+      BasicJson(Container<T> const &values)
       {
         jArray array;
         array.reserve(values.size());
@@ -148,6 +774,9 @@ namespace jjson {
       }
 
       JsonType get_type() const {
+        if (auto const *raw = std::get_if<RawNumber>(&mValue)) {
+          return raw->type();
+        }
         return static_cast<JsonType>(mValue.index());
       }
 
@@ -179,13 +808,13 @@ namespace jjson {
         return get_type() == JsonType::Object;
       }
 
-      template <JsonTypeConcept T>
+      template <JsonTypeConcept<Json> T>
       Json & operator = (T const &value) {
         this->mValue = value;
         return *this;
       }
 
-      template <JsonTypeConcept T>
+      template <JsonTypeConcept<Json> T>
       Json & operator = (T &&value) {
         this->mValue = std::move(value);
         return *this;
@@ -196,7 +825,7 @@ namespace jjson {
         return *this;
       }
 
-      Json & operator = (Json &&value) {
+      Json & operator = (Json &&value) noexcept(std::is_nothrow_move_assignable_v<decltype(mValue)>) {
         mValue = std::move(value.mValue);
         return *this;
       }
@@ -213,20 +842,20 @@ namespace jjson {
         return get_type() == JsonType::Bool && std::get<bool>(mValue) == value;
       }
 
-      bool operator == (int64_t value) const {
-        return get_type() == JsonType::Integer && std::get<int64_t>(mValue) == value;
+      bool operator == (integer_type value) const {
+        return get<integer_type>() == value;
       }
 
-      bool operator == (double value) const {
-        return get_type() == JsonType::Decimal && std::get<double>(mValue) == value;
+      bool operator == (decimal_type value) const {
+        return get<decimal_type>() == value;
       }
 
       bool operator == (const char *value) const {
-        return get_type() == JsonType::Text && std::get<std::string>(mValue) == value;
+        return get_type() == JsonType::Text && std::get<text_type>(mValue) == value;
       }
 
-      bool operator == (std::string const &value) const {
-        return get_type() == JsonType::Text && std::get<std::string>(mValue) == value;
+      bool operator == (text_type const &value) const {
+        return get_type() == JsonType::Text && std::get<text_type>(mValue) == value;
       }
 
       bool operator == (jArray const &value) const {
@@ -251,7 +880,7 @@ namespace jjson {
         throw std::runtime_error("invalid access");
       }
 
-      Json & operator [] (std::string const &key) {
+      Json & operator [] (text_type const &key) {
         if (auto *value = std::get_if<jObject>(&mValue)) {
           if (auto i = value->find(key); i != value->end()) {
             return i->second;
@@ -260,7 +889,7 @@ namespace jjson {
         throw std::runtime_error("invalid access");
       }
 
-      Json const & operator [] (std::string const &key) const {
+      Json const & operator [] (text_type const &key) const {
         if (auto *value = std::get_if<jObject>(&mValue)) {
           if (auto i = value->find(key); i != value->end()) {
             return i->second;
@@ -269,20 +898,26 @@ namespace jjson {
         throw std::runtime_error("invalid access");
       }
 
-      bool has(std::string const &key) const {
+      bool has(text_type const &key) const {
         auto const *object = std::get_if<jObject>(&mValue);
         return object && object->contains(key);
       }
 
       template <typename T>
       std::optional<T> get() const {
-        if constexpr (std::same_as<T, int>) {
-          if (auto *v = std::get_if<int64_t>(&mValue)) {
+        if constexpr (std::same_as<T, int> || std::same_as<T, integer_type> || std::same_as<T, float> || std::same_as<T, decimal_type>) {
+          if (auto *raw = std::get_if<RawNumber>(&mValue)) {
+            return raw->template get<T>();
+          }
+        }
+
+        if constexpr (std::same_as<T, int> && !std::same_as<T, integer_type>) {
+          if (auto *v = std::get_if<integer_type>(&mValue)) {
             return static_cast<int>(*v);
           }
           return {};
-        } else if constexpr (std::same_as<T, float>) {
-          if (auto *v = std::get_if<double>(&mValue)) {
+        } else if constexpr (std::same_as<T, float> && !std::same_as<T, decimal_type>) {
+          if (auto *v = std::get_if<decimal_type>(&mValue)) {
             return static_cast<float>(*v);
           }
           return {};
@@ -291,13 +926,21 @@ namespace jjson {
             return nullptr;
           }
           return {};
-        } else if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, double> ||
-                             std::is_same_v<T, std::string> || std::is_same_v<T, jArray> ||
-                             std::is_same_v<T, jObject> || std::is_same_v<T, bool>) {
+        } else if constexpr (std::is_same_v<T, integer_type> || std::is_same_v<T, decimal_type> ||
+                             std::is_same_v<T, text_type> || std::is_same_v<T, jArray> ||
+                             std::is_same_v<T, jObject> || std::is_same_v<T, bool> ||
+                             std::is_same_v<T, RawNumber>) {
           if (auto *v = std::get_if<T>(&mValue)) {
             return *v;
           }
           return {};
+        } else if constexpr (requires (T &value) { { json_to(*this, value) } -> std::same_as<bool>; }) {
+          // converters returning bool report failures without exceptions
+          T value{};
+          if (!json_to(*this, value)) {
+            return {};
+          }
+          return value;
         } else {
           try {
             T value{};
@@ -326,61 +969,761 @@ namespace jjson {
         return out.str();
       }
 
-      jValue const & get_value() const {
-        return mValue;
+      // writes the text of dump() to out, without building it in memory first
+      void dump(std::ostream &out) const {
+        auto flags = out.flags(std::ios::dec | std::ios::boolalpha);
+        auto precision = out.precision(6);
+
+        out.width(0);
+        _dump(*this, out);
+        out.flags(flags);
+        out.precision(precision);
       }
 
-    private:
-      jValue mValue;
+      // Same output as dump(). Large arrays and objects are cut into chunks of
+      // similar size that are serialized concurrently on up to threads threads
+      // and then concatenated in order.
+      std::string dump_parallel(std::size_t threads = std::thread::hardware_concurrency()) const {
+        if (threads <= 1) {
+          return dump();
+        }
 
-      static std::optional<Json> _parse(ParseState &ps) {
-        ps.skip_space();
-        int c = ps.peek();
+        std::vector<DumpWeight> weights;
+        std::size_t weight = _weigh(*this, weights);
+        std::size_t grain = std::max<std::size_t>(weight/(threads*8), 1024);
 
-        if (c == -1) {
-          return Json{};
-        } else if (c == 'n') {
-          return _read_null(ps);
-        } else if (c == 'f' || c == 't') {
-          return _read_bool(ps);
-        } else if (c == '+' || c == '-' || c == '.' || (c >= '0' && c <= '9')) {
-          return _read_number(ps);
-        } else if (c == '"') {
-          auto str = _read_string(ps);
-          if (str) return Json{std::move(str.value())};
-          return {};
-        } else if (c == '[') {
-          return _read_array(ps);
-        } else if (c == '{') {
-          return _read_object(ps);
+        if (weight < 2*grain) {
+          return dump();
         }
 
-        return {};
-      }
+        std::vector<DumpChunk> chunks(1);
+        std::size_t index = 0;
 
-      static std::optional<Json> _read_null(ParseState &ps) {
-        if (ps.get() == 'n' && ps.get() == 'u' && ps.get() == 'l' && ps.get() == 'l') {
-          return Json{};
-        }
-        return {};
-      }
+        _split(*this, nullptr, true, grain, weights, index, chunks);
 
-      static std::optional<Json> _read_bool(ParseState &ps) {
-        int c = ps.get();
+        std::vector<std::string> outputs(chunks.size());
+        std::atomic<std::size_t> next{0};
+        std::exception_ptr error;
+        std::atomic_flag failed;
+
+        auto work = [&]() {
+          try {
+            std::ostringstream out;
+            out << std::boolalpha;
+            for (std::size_t i; (i = next++) < chunks.size();) {
+              out.str({});
+              _dump_chunk(chunks[i], out);
+              outputs[i] = out.str();
+            }
+          } catch (...) {
+            if (!failed.test_and_set()) {
+              error = std::current_exception();
+            }
+            next = chunks.size();
+          }
+        };
+
+        {
+          std::vector<std::jthread> workers;
+
+          for (std::size_t i = 1; i < std::min(threads, chunks.size()); i++) {
+            workers.emplace_back(work);
+          }
+
+          work();
+        }
+
+        if (error) {
+          std::rethrow_exception(error);
+        }
+
+        std::size_t size = 0;
+
+        for (auto const &output : outputs) {
+          size += output.size();
+        }
+
+        std::string result;
+
+        result.reserve(size);
+
+        for (auto const &output : outputs) {
+          result += output;
+        }
+
+        return result;
+      }
+
+      // deep heap usage of the value (the Json itself is not included)
+      MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        _memory_usage(*this, usage);
+        return usage;
+      }
+
+      // releases the unused capacity of every string, array and bucket
+      // array in the tree, such as the room the parser reserves for arrays
+      void shrink_to_fit() {
+        if (auto *text = std::get_if<text_type>(&mValue)) {
+          text->shrink_to_fit();
+        } else if (auto *raw = std::get_if<RawNumber>(&mValue)) {
+          raw->mText.shrink_to_fit();
+        } else if (auto *array = std::get_if<jArray>(&mValue)) {
+          array->shrink_to_fit();
+          for (auto &i : *array) {
+            i.shrink_to_fit();
+          }
+        } else if (auto *object = std::get_if<jObject>(&mValue)) {
+          if constexpr (requires { typename jObject::node_type; }) {
+            // keys are const in place, so the members with slack are reinserted
+            std::vector<typename jObject::node_type> nodes;
+
+            for (auto i = object->begin(); i != object->end();) {
+              auto next = std::next(i);
+              if (_string_slack(i->first) > 0) {
+                nodes.push_back(object->extract(i));
+              }
+              i = next;
+            }
+
+            for (auto &node : nodes) {
+              node.key().shrink_to_fit();
+              object->insert(std::move(node));
+            }
+          }
+
+          if constexpr (requires { object->rehash(0); }) {
+            object->rehash(0);
+          } else if constexpr (requires { object->shrink_to_fit(); }) {
+            object->shrink_to_fit();
+          }
+
+          for (auto &[k, v] : *object) {
+            v.shrink_to_fit();
+          }
+        }
+      }
+
+      jValue const & get_value() const {
+        return mValue;
+      }
+
+    private:
+      template <typename>
+      friend class BasicParser;
+
+      // part of a dump_parallel() output: text, then values separated by commas
+      struct DumpChunk {
+        std::string text;
+        std::vector<std::pair<text_type const *, Json const *>> values; // keys are null inside arrays
+        std::size_t weight = 0;
+      };
+
+      // weight of a container, and the index in the weights after those of
+      // the containers inside it
+      struct DumpWeight {
+        std::size_t weight = 0;
+        std::size_t end = 0;
+      };
+
+      jValue mValue;
+
+      // heap bytes of a string, zero while it fits in the string itself
+      template <typename String>
+      static std::size_t _string_heap(String const &text) {
+        return text.capacity() > String{}.capacity() ? text.capacity() + 1 : 0;
+      }
+
+      template <typename String>
+      static std::size_t _string_slack(String const &text) {
+        return _string_heap(text) > 0 ? text.capacity() - text.size() : 0;
+      }
+
+      static void _memory_usage(Json const &value, MemoryUsage &usage) {
+        auto string = [&](auto const &text) {
+          usage.strings += _string_heap(text);
+          usage.slack += _string_slack(text);
+        };
+
+        if (auto const *text = std::get_if<text_type>(&value.mValue)) {
+          string(*text);
+        } else if (auto const *raw = std::get_if<RawNumber>(&value.mValue)) {
+          string(raw->mText);
+        } else if (auto const *array = std::get_if<jArray>(&value.mValue)) {
+          usage.arrays += array->capacity()*sizeof(Json);
+          usage.nodes += array->size()*sizeof(Json);
+          usage.slack += (array->capacity() - array->size())*sizeof(Json);
+          for (auto const &i : *array) {
+            _memory_usage(i, usage);
+          }
+        } else if (auto const *object = std::get_if<jObject>(&value.mValue)) {
+          if constexpr (requires { object->capacity(); }) {
+            usage.objects += object->capacity()*sizeof(typename jObject::value_type);
+            usage.slack += (object->capacity() - object->size())*sizeof(typename jObject::value_type);
+          } else {
+            usage.objects += object->size()*(sizeof(void *) + sizeof(std::size_t) + sizeof(typename jObject::value_type));
+          }
+          if constexpr (requires { object->bucket_count(); }) {
+            usage.buckets += object->bucket_count()*sizeof(void *);
+          }
+          usage.nodes += object->size()*sizeof(Json);
+          for (auto const &[k, v] : *object) {
+            string(k);
+            _memory_usage(v, usage);
+          }
+        }
+      }
+
+      // roughly proportional to the size of the serialized value. The
+      // weights of the containers are appended to weights in pre-order, so
+      // _split() doesn't walk the subtrees again.
+      static std::size_t _weigh(Json const &value, std::vector<DumpWeight> &weights) {
+        std::size_t weight = 1;
+
+        if (auto const *text = std::get_if<text_type>(&value.mValue)) {
+          return weight + text->size()/32;
+        }
+
+        if (!value.is_array() && !value.is_object()) {
+          return weight;
+        }
+
+        std::size_t index = weights.size();
+
+        weights.emplace_back();
+
+        if (auto const *array = std::get_if<jArray>(&value.mValue)) {
+          for (auto const &i : *array) {
+            weight += _weigh(i, weights);
+          }
+        } else {
+          for (auto const &[k, v] : std::get<jObject>(value.mValue)) {
+            weight += 1 + k.size()/32 + _weigh(v, weights);
+          }
+        }
+
+        weights[index] = {weight, weights.size()};
+
+        return weight;
+      }
+
+      // values lighter than grain are serialized whole, heavier containers
+      // are opened and their members spread over chunks of about grain.
+      // index walks weights along with the containers.
+      void _split(Json const &value, text_type const *key, bool first, std::size_t grain,
+          std::vector<DumpWeight> const &weights, std::size_t &index, std::vector<DumpChunk> &chunks) const {
+        bool array = value.is_array();
+        bool container = array || value.is_object();
+        std::size_t weight = 1;
+
+        if (container) {
+          weight = weights[index].weight;
+        } else if (auto const *text = std::get_if<text_type>(&value.mValue)) {
+          weight += text->size()/32;
+        }
+
+        if (weight <= grain || !container) {
+          if (container) {
+            index = weights[index].end;
+          }
+
+          if (chunks.back().weight >= grain) {
+            chunks.emplace_back();
+          }
+
+          auto &chunk = chunks.back();
+
+          if (!first && chunk.values.empty()) {
+            chunk.text += ',';
+          }
+
+          chunk.values.emplace_back(key, &value);
+          chunk.weight += weight;
+
+          return;
+        }
+
+        std::ostringstream out;
+
+        if (!first) {
+          out << ",";
+        }
+
+        if (key != nullptr) {
+          _dump_string(*key, out);
+          out << ":";
+        }
+
+        out << (array ? "[" : "{");
+
+        _split_text(out.str(), chunks);
+
+        first = true;
+        index++;
+
+        if (array) {
+          for (auto const &i : value.get_or_throw<jArray>()) {
+            _split(i, nullptr, first, grain, weights, index, chunks);
+            first = false;
+          }
+        } else {
+          for (auto const &[k, v] : value.get_or_throw<jObject>()) {
+            _split(v, &k, first, grain, weights, index, chunks);
+            first = false;
+          }
+        }
+
+        _split_text(array ? "]" : "}", chunks);
+      }
+
+      static void _split_text(std::string const &text, std::vector<DumpChunk> &chunks) {
+        if (!chunks.back().values.empty()) {
+          chunks.emplace_back();
+        }
+
+        chunks.back().text += text;
+      }
+
+      void _dump_chunk(DumpChunk const &chunk, std::ostream &out) const {
+        out << chunk.text;
+
+        bool first = true;
+
+        for (auto const &[key, value] : chunk.values) {
+          if (!first) out << ",";
+          first = false;
+          if (key != nullptr) {
+            _dump_string(*key, out);
+            out << ":";
+          }
+          _dump(*value, out);
+        }
+      }
+
+      void _dump(Json const &value, std::ostream &out) const {
+        if (auto const *raw = std::get_if<RawNumber>(&value.mValue)) {
+          out << raw->text();
+          return;
+        }
+
+        switch (value.get_type()) {
+          case JsonType::Null:
+            out << "null";
+            break;
+          case JsonType::Bool:
+            out << value.get_or_throw<bool>();
+            break;
+          case JsonType::Integer:
+            out << value.get_or_throw<integer_type>();
+            break;
+          case JsonType::Decimal: {
+            decimal_type d = value.get_or_throw<decimal_type>();
+            out << d;
+            if (d == static_cast<int64_t>(d)) {
+              out << ".0";
+            }
+            break;
+          }
+          case JsonType::Text:
+            _dump_string(value.get_or_throw<text_type>(), out);
+            break;
+          case JsonType::Array: {
+            auto const &array = value.get_or_throw<jArray>();
+            out << "[";
+            bool first = true;
+            for (auto const &i : array) {
+              if (!first) out << ",";
+              first = false;
+              _dump(i, out);
+            }
+            out << "]";
+            break;
+          }
+          case JsonType::Object: {
+            auto const &object = value.get_or_throw<jObject>();
+            out << "{";
+            bool first = true;
+            for (auto const &[k, v] : object) {
+              if (!first) out << ",";
+              first = false;
+              _dump_string(k, out);
+              out << ":";
+              _dump(v, out);
+            }
+            out << "}";
+            break;
+          }
+        }
+      }
+
+      static void _dump_string(text_type const &value, std::ostream &out) {
+        static constexpr char hex[] = "0123456789abcdef";
+
+        const char *run = value.data();
+        const char *end = value.data() + value.size();
+
+        out << '"';
+
+        for (const char *i = run; i < end; i++) {
+          auto c = static_cast<unsigned char>(*i);
+
+          if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+          }
+
+          out.write(run, i - run);
+          run = i + 1;
+
+          switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\b': out << "\\b"; break;
+            case '\f': out << "\\f"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+              out << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+          }
+        }
+
+        out.write(run, end - run);
+        out << '"';
+      }
+
+      friend bool operator == (Json const &lhs, Json const &rhs) {
+        auto const *a = std::get_if<RawNumber>(&lhs.mValue);
+        auto const *b = std::get_if<RawNumber>(&rhs.mValue);
+
+        // raw numbers are equal to the values they convert to
+        if (a != nullptr || b != nullptr) {
+          if (a != nullptr && b != nullptr) {
+            return *a == *b;
+          }
+
+          if (lhs.get_type() != rhs.get_type()) {
+            return false;
+          }
+
+          if (lhs.is_integer()) {
+            auto value = lhs.get<integer_type>();
+            return value && value == rhs.get<integer_type>();
+          }
+
+          auto value = lhs.get<decimal_type>();
+          return value && value == rhs.get<decimal_type>();
+        }
+
+        if (lhs.mValue.index() != rhs.mValue.index()) {
+          return false;
+        }
+
+        switch (lhs.mValue.index()) {
+          case 0: return true;
+          case 1: return std::get<bool>(lhs.mValue) == std::get<bool>(rhs.mValue);
+          case 2: return std::get<integer_type>(lhs.mValue) == std::get<integer_type>(rhs.mValue);
+          case 3: return std::get<decimal_type>(lhs.mValue) == std::get<decimal_type>(rhs.mValue);
+          case 4: return std::get<text_type>(lhs.mValue) == std::get<text_type>(rhs.mValue);
+          case 5: {
+            auto &a = std::get<jArray>(lhs.mValue);
+            auto &b = std::get<jArray>(rhs.mValue);
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+          }
+          case 6: {
+            // map equality is independent of the iteration order
+            return std::get<jObject>(lhs.mValue) == std::get<jObject>(rhs.mValue);
+          }
+          default: return false;
+        }
+      }
+
+      friend std::ostream & operator << (std::ostream &out, Json const &value) {
+        out << value.dump();
+        return out;
+      }
+
+  };
+
+  using jArray = Json::array_type;
+  using jObject = Json::object_type;
+  using jValue = Json::variant_type;
+
+  class ColumnReader;
+  class JsonPath;
+
+  namespace detail {
+    template <typename Object>
+    struct NodePool {
+    };
+
+    template <typename Object>
+      requires requires { typename Object::node_type; }
+    struct NodePool<Object> : std::vector<typename Object::node_type> {
+    };
+  }
+
+  enum class NumberMode {
+    Convert, // numbers become int64_t/double while parsing
+    Raw // numbers are kept as RawNumber text and converted on access
+  };
+
+  // Parses documents into Json values. A Parser keeps its scratch buffers
+  // (number tokens, keys, object bookkeeping and a pool of object nodes)
+  // between calls, and parse_into() reuses the strings, vectors and maps the
+  // target already owns, so parsing similar messages in a loop allocates
+  // close to nothing once it is warm. A Parser is not thread-safe.
+  // BasicParser<Traits> builds BasicJson<Traits> values.
+  template <typename Traits>
+  class BasicParser {
+
+    // the names used by the members, bound to this instantiation
+    using Json = BasicJson<Traits>;
+    using jArray = typename Json::array_type;
+    using jObject = typename Json::object_type;
+    using jValue = typename Json::variant_type;
+
+    public:
+      BasicParser() = default;
+
+      explicit BasicParser(NumberMode numbers)
+        : mNumbers{numbers} {
+      }
+
+      std::optional<Json> parse(std::string_view data) {
+        return parse(data, ParseFilter{});
+      }
+
+      template <ParseFilterConcept<Json> Filter>
+      std::optional<Json> parse(std::string_view data, Filter const &filter) {
+        Json result;
+
+        if (!parse_into(data, result, filter)) {
+          return {};
+        }
+
+        return result;
+      }
+
+      template <typename T>
+        requires requires (T const &source) {
+          { source.filter() } -> ParseFilterConcept<Json>;
+        }
+      std::optional<Json> parse(std::string_view data, T const &source) {
+        return parse(data, source.filter());
+      }
+
+      std::expected<Json, ParseError> try_parse(std::string_view data) {
+        return try_parse(data, ParseFilter{});
+      }
+
+      template <ParseFilterConcept<Json> Filter>
+      std::expected<Json, ParseError> try_parse(std::string_view data, Filter const &filter) {
+        Json result;
+
+        if (!parse_into(data, result, filter)) {
+          return std::unexpected{mError};
+        }
+
+        return result;
+      }
+
+      template <typename T>
+        requires requires (T const &source) {
+          { source.filter() } -> ParseFilterConcept<Json>;
+        }
+      std::expected<Json, ParseError> try_parse(std::string_view data, T const &source) {
+        return try_parse(data, source.filter());
+      }
+
+      // out is left in an unspecified (but valid) state if parsing fails,
+      // and error() tells why
+      bool parse_into(std::string_view data, Json &out) {
+        return parse_into(data, out, ParseFilter{});
+      }
+
+      template <ParseFilterConcept<Json> Filter>
+      bool parse_into(std::string_view data, Json &out, Filter const &filter) {
+        mState = ParseState{data.data(), data.data() + data.size()};
+        mVisited.clear();
+
+        if (!_parse(out, filter)) {
+          _locate(data);
+          return false;
+        }
+
+        return true;
+      }
+
+      template <typename T>
+        requires requires (T const &source) {
+          { source.filter() } -> ParseFilterConcept<Json>;
+        }
+      bool parse_into(std::string_view data, Json &out, T const &source) {
+        return parse_into(data, out, source.filter());
+      }
+
+      // error of the last failed parse
+      ParseError const & error() const {
+        return mError;
+      }
+
+    private:
+      friend class ColumnReader;
+      friend class JsonPath;
+      friend class RawNumber;
+      friend struct ParseState;
+
+      NumberMode mNumbers = NumberMode::Convert;
+      ParseState mState{};
+      // single error slot: set where the failure is detected, the callers
+      // only return false
+      ParseError mError;
+      const char *mErrorAt = nullptr;
+      std::string mToken;
+      typename Json::text_type mKey;
+      // members parsed by the objects being read, used to drop stale members
+      // when an object is reused
+      std::vector<Json const *> mVisited;
+      // pool of object members, for maps with node handles
+      [[no_unique_address]] detail::NodePool<jObject> mNodes;
+
+      static constexpr bool _pooled = requires { typename jObject::node_type; };
+
+      template <typename T>
+      static T & _reuse(Json &out) {
+        if (auto *value = std::get_if<T>(&out.mValue)) {
+          return *value;
+        }
+        return out.mValue.template emplace<T>();
+      }
+
+      bool _fail(ParseErrorKind kind, const char *at) {
+        mError.kind = (at >= mState.end && kind != ParseErrorKind::Rejected) ? ParseErrorKind::UnexpectedEnd : kind;
+        mErrorAt = at;
+        return false;
+      }
+
+      bool _fail(ParseErrorKind kind) {
+        return _fail(kind, mState.p);
+      }
+
+      // fills the error position, only run after a failure
+      void _locate(std::string_view data) {
+        auto offset = static_cast<std::size_t>(std::min(mErrorAt, mState.end) - data.data());
+        auto before = data.substr(0, offset);
+        auto newline = before.rfind('\n');
+
+        mError.offset = offset;
+        mError.line = static_cast<std::size_t>(std::count(before.begin(), before.end(), '\n')) + 1;
+        mError.column = offset - (newline == std::string_view::npos ? 0 : newline + 1) + 1;
+      }
+
+      template <typename Filter>
+      bool _parse(Json &out, Filter const &filter) {
+        auto &ps = mState;
+
+        ps.skip_space();
+
+        const char *begin = ps.p;
+        int c = ps.peek();
+
+        if (c == -1) {
+          out.mValue = nullptr;
+        } else if (c == 'n') {
+          if (!_read_null()) {
+            return _fail(ParseErrorKind::InvalidLiteral, begin);
+          }
+          out.mValue = nullptr;
+        } else if (c == 'f' || c == 't') {
+          if (!_read_bool(out)) {
+            return _fail(ParseErrorKind::InvalidLiteral, begin);
+          }
+        } else if (c == '+' || c == '-' || c == '.' || (c >= '0' && c <= '9')) {
+          if (!_read_number(out)) {
+            return _fail(ParseErrorKind::InvalidNumber, begin);
+          }
+        } else if (c == '"') {
+          if (!filter.begin(JsonType::Text)) {
+            return _fail(ParseErrorKind::Rejected, begin);
+          }
+          auto &text = _reuse<typename Json::text_type>(out);
+          text.clear();
+          if (!ps.read_string(text)) {
+            return _fail(ParseErrorKind::InvalidString);
+          }
+        } else if (c == '[') {
+          if (!filter.begin(JsonType::Array)) {
+            return _fail(ParseErrorKind::Rejected, begin);
+          }
+          if (!_read_array(out, filter)) {
+            return false;
+          }
+        } else if (c == '{') {
+          if (!filter.begin(JsonType::Object)) {
+            return _fail(ParseErrorKind::Rejected, begin);
+          }
+          if (!_read_object(out, filter)) {
+            return false;
+          }
+        } else {
+          return _fail(ParseErrorKind::UnexpectedCharacter);
+        }
+
+        if (!filter.end(out)) {
+          return _fail(ParseErrorKind::Rejected, begin);
+        }
+
+        return true;
+      }
+
+      bool _read_null() {
+        auto &ps = mState;
+        return ps.get() == 'n' && ps.get() == 'u' && ps.get() == 'l' && ps.get() == 'l';
+      }
+
+      bool _read_bool(Json &out) {
+        auto &ps = mState;
+        int c = ps.get();
         if (c == 'f') {
           if (ps.get() == 'a' && ps.get() == 'l' && ps.get() == 's' && ps.get() == 'e') {
-            return Json{false};
+            out.mValue = false;
+            return true;
           }
         } else if (c == 't') {
           if (ps.get() == 'r' && ps.get() == 'u' && ps.get() == 'e') {
-            return Json{true};
+            out.mValue = true;
+            return true;
           }
         }
-        return {};
+        return false;
+      }
+
+      bool _read_number(Json &out) {
+        auto &ps = mState;
+        const char *begin = ps.p;
+        char type = _lex_number(ps, mToken);
+
+        if (type == 'u') {
+          return false;
+        }
+
+        if (mNumbers == NumberMode::Raw) {
+          auto &raw = _reuse<RawNumber>(out);
+          raw.mText.assign(begin, ps.p);
+          raw.mType = (type == 'f' || type == 'c') ? JsonType::Decimal : JsonType::Integer;
+          return true;
+        }
+
+        return _convert_number(mToken, type, out.mValue);
       }
 
-      static std::optional<Json> _read_number(ParseState &ps) {
-        std::string token;
+      // reads the number at ps into token (lowercase, without the base
+      // prefix) and returns its kind: 'i', 'o', 'b' or 'h' for decimal,
+      // octal, binary or hexadecimal integers, 'f' for decimals, 'c' for
+      // decimals with an exponent and 'u' if it is malformed
+      template <typename Token>
+      static char _lex_number(ParseState &ps, Token &token) {
+        token.clear();
         char type = 'u';
         bool first = false;
 
@@ -475,27 +1818,33 @@ namespace jjson {
 
         if (type == 'u' || (terminator != -1 && terminator != '}' && terminator != ']' &&
             terminator != ',' && !std::isspace(terminator))) {
-          return {};
+          return 'u';
         }
 
-        Json result;
+        return type;
+      }
+
+      // converts a token read by _lex_number, returning false if it doesn't
+      // fit (out is still set, as the conversion leaves it)
+      static bool _convert_number(std::string &token, char type, jValue &out) {
+        bool ok = true;
 
         if (type == 'i') {
-          int64_t v = 0;
-          std::from_chars(token.data(), token.data() + token.size(), v);
-          result = v;
+          typename Json::integer_type v = 0;
+          ok = std::from_chars(token.data(), token.data() + token.size(), v).ec == std::errc{};
+          out = v;
         } else if (type == 'b') {
-          int64_t v = 0;
-          std::from_chars(token.data(), token.data() + token.size(), v, 2);
-          result = v;
+          typename Json::integer_type v = 0;
+          ok = std::from_chars(token.data(), token.data() + token.size(), v, 2).ec == std::errc{};
+          out = v;
         } else if (type == 'o') {
-          int64_t v = 0;
-          std::from_chars(token.data(), token.data() + token.size(), v, 8);
-          result = v;
+          typename Json::integer_type v = 0;
+          ok = std::from_chars(token.data(), token.data() + token.size(), v, 8).ec == std::errc{};
+          out = v;
         } else if (type == 'h') {
-          int64_t v = 0;
-          std::from_chars(token.data(), token.data() + token.size(), v, 16);
-          result = v;
+          typename Json::integer_type v = 0;
+          ok = std::from_chars(token.data(), token.data() + token.size(), v, 16).ec == std::errc{};
+          out = v;
         } else if (type == 'f') {
           if (token.front() == '.') {
             token = '0' + token;
@@ -503,9 +1852,9 @@ namespace jjson {
           if (token.back() == '.') {
             token += '0';
           }
-          double v = 0;
-          std::from_chars(token.data(), token.data() + token.size(), v);
-          result = v;
+          typename Json::decimal_type v = 0;
+          ok = std::from_chars(token.data(), token.data() + token.size(), v).ec == std::errc{};
+          out = v;
         } else if (type == 'c') {
           if (token.back() == 'e') {
             token += '+';
@@ -523,66 +1872,78 @@ namespace jjson {
           std::from_chars(baseStr.data(), baseStr.data() + baseStr.size(), base);
           std::from_chars(multStr.data(), multStr.data() + multStr.size(), mult);
 
-          result = base * std::pow(10, mult);
+          out = static_cast<typename Json::decimal_type>(base * std::pow(10, mult));
         }
 
-        return result;
+        return ok;
       }
 
-      static std::optional<std::string> _read_string(ParseState &ps) {
-        ps.get(); // skip leading '"'
-        std::string result;
-        bool escape = false;
+      template <typename Filter>
+      bool _read_array(Json &out, Filter const &filter) {
+        auto &ps = mState;
 
-        while (ps.p < ps.end) {
-          int c = ps.get();
+        ps.get(); // skip '['
 
-          if (c == '"' && !escape) {
-            return result;
-          }
+        auto &result = _reuse<jArray>(out);
+        std::size_t count = 0;
 
-          if (c == '\\' && !escape) {
-            escape = true;
-          } else {
-            result += static_cast<char>(c);
-            escape = false;
-          }
+        if (result.capacity() == 0) {
+          result.reserve(32);
         }
 
-        return {};
-      }
-
-      static std::optional<Json> _read_array(ParseState &ps) {
-        ps.get(); // skip '['
-        jArray result;
-
-        result.reserve(32);
-
         while (ps.p < ps.end) {
           ps.skip_space();
           int c = ps.peek();
 
           if (c == ']') {
             ps.get();
-            return Json{std::move(result)};
+            result.erase(result.begin() + count, result.end());
+            return true;
           } else if (c == ',') {
             ps.get();
           } else {
-            auto valueOpt = _parse(ps);
-            if (valueOpt) {
-              result.push_back(std::move(valueOpt.value()));
-            } else {
-              return {};
+            auto child = filter.element(count);
+
+            if constexpr (requires { child.skip(); }) {
+              if (child.skip()) {
+                if (!ps.skip_value()) {
+                  return _fail(ParseErrorKind::UnexpectedCharacter);
+                }
+                continue;
+              }
+            }
+
+            if (count == result.size()) {
+              result.emplace_back();
             }
+
+            if (!_parse(result[count], child)) {
+              return false;
+            }
+
+            count++;
           }
         }
 
-        return {};
+        return _fail(ParseErrorKind::UnexpectedEnd);
       }
 
-      static std::optional<Json> _read_object(ParseState &ps) {
+      template <typename Filter>
+      bool _read_object(Json &out, Filter const &filter) {
+        auto &ps = mState;
+
         ps.get(); // skip '{'
-        jObject result;
+
+        auto &result = _reuse<jObject>(out);
+
+        // without node handles members can't be recycled, so the object is
+        // rebuilt
+        if constexpr (!_pooled) {
+          result.clear();
+        }
+
+        std::size_t previous = result.size();
+        std::size_t base = mVisited.size();
 
         while (ps.p < ps.end) {
           ps.skip_space();
@@ -590,124 +1951,225 @@ namespace jjson {
 
           if (c == '}') {
             ps.get();
-            return Json{std::move(result)};
+            if constexpr (_pooled) {
+              if (previous > 0) {
+                _erase_stale(result, base);
+              }
+            }
+            return true;
           } else if (c == ',') {
             ps.get();
           } else {
-            auto keyStr = _read_string(ps);
-            if (!keyStr || keyStr->empty()) {
-              return {};
+            const char *key = ps.p;
+
+            mKey.clear();
+            if (c != '"') {
+              return _fail(ParseErrorKind::InvalidKey);
+            }
+            if (!ps.read_string(mKey)) {
+              return _fail(ParseErrorKind::InvalidString);
+            }
+            if (mKey.empty()) {
+              return _fail(ParseErrorKind::InvalidKey, key);
             }
 
             ps.skip_space();
-            if (ps.p >= ps.end || ps.get() != ':') {
-              return {};
+            if (ps.peek() != ':') {
+              return _fail(ParseErrorKind::ExpectedColon);
             }
+            ps.get();
 
-            auto valueOpt = _parse(ps);
-            if (!valueOpt) {
-              return {};
+            auto child = filter.member(mKey);
+
+            if constexpr (requires { child.skip(); }) {
+              if (child.skip()) {
+                if (!ps.skip_value()) {
+                  return _fail(ParseErrorKind::UnexpectedCharacter);
+                }
+                continue;
+              }
             }
 
-            result.emplace(std::move(keyStr.value()), std::move(valueOpt.value()));
-          }
-        }
+            Json *value = nullptr;
 
-        return {};
-      }
+            if (auto i = result.find(mKey); i != result.end()) {
+              value = &i->second;
+            } else if constexpr (_pooled) {
+              if (!mNodes.empty()) {
+                auto node = std::move(mNodes.back());
+                mNodes.pop_back();
+                node.key() = mKey;
+                value = &result.insert(std::move(node)).position->second;
+              }
+            }
 
-      void _dump(Json const &value, std::ostringstream &out) const {
-        switch (value.get_type()) {
-          case JsonType::Null:
-            out << "null";
-            break;
-          case JsonType::Bool:
-            out << value.get_or_throw<bool>();
-            break;
-          case JsonType::Integer:
-            out << value.get_or_throw<int64_t>();
-            break;
-          case JsonType::Decimal: {
-            double d = value.get_or_throw<double>();
-            out << d;
-            if (d == static_cast<int64_t>(d)) {
-              out << ".0";
+            if (value == nullptr) {
+              value = &result.try_emplace(mKey).first->second;
             }
-            break;
-          }
-          case JsonType::Text:
-            out << std::quoted(value.get_or_throw<std::string>());
-            break;
-          case JsonType::Array: {
-            auto const &array = value.get_or_throw<jArray>();
-            out << "[";
-            bool first = true;
-            for (auto const &i : array) {
-              if (!first) out << ",";
-              first = false;
-              _dump(i, out);
+
+            if (previous > 0) {
+              mVisited.push_back(value);
+            }
+
+            if (!_parse(*value, child)) {
+              return false;
             }
-            out << "]";
-            break;
           }
-          case JsonType::Object: {
-            auto const &object = value.get_or_throw<jObject>();
-            out << "{";
-            bool first = true;
-            for (auto const &[k, v] : object) {
-              if (!first) out << ",";
-              first = false;
-              out << std::quoted(k) << ":";
-              _dump(v, out);
+        }
+
+        return _fail(ParseErrorKind::UnexpectedEnd);
+      }
+
+      // members of a reused object that were not in the new document are
+      // moved to the node pool
+      void _erase_stale(jObject &object, std::size_t base) requires _pooled {
+        auto begin = mVisited.begin() + base;
+        auto end = mVisited.end();
+
+        std::sort(begin, end);
+        end = std::unique(begin, end);
+
+        if (static_cast<std::size_t>(end - begin) != object.size()) {
+          for (auto i = object.begin(); i != object.end();) {
+            auto next = std::next(i);
+            if (!std::binary_search(begin, end, &i->second)) {
+              mNodes.push_back(object.extract(i));
             }
-            out << "}";
-            break;
+            i = next;
           }
         }
+
+        mVisited.erase(mVisited.begin() + base, mVisited.end());
       }
 
-      friend bool operator == (Json const &lhs, Json const &rhs) {
-        if (lhs.mValue.index() != rhs.mValue.index()) {
+  };
+
+  inline bool ParseState::skip_value() {
+    // lexes numbers without keeping the digits
+    struct Discard {
+      void clear() {}
+      Discard & operator+=(char) {
+        return *this;
+      }
+    };
+
+    std::string open; // brackets not closed yet, innermost last
+    Discard token;
+
+    skip_space();
+
+    while (p < end) {
+      char c = *p;
+
+      if (c == '"') {
+        if (!skip_string()) {
+          return false;
+        }
+      } else if (c == '[' || c == '{') {
+        open += c;
+        ++p;
+      } else if (c == ']' || c == '}') {
+        if (open.empty() || open.back() != (c == ']' ? '[' : '{')) {
           return false;
         }
+        open.pop_back();
+        ++p;
+      } else if (c == ',' || c == ':' || std::isspace(static_cast<unsigned char>(c))) {
+        if (open.empty()) {
+          return false;
+        }
+        ++p;
+      } else if (c == 'n' || c == 't' || c == 'f') {
+        std::string_view literal = c == 'n' ? "null" : c == 't' ? "true" : "false";
 
-        switch (lhs.mValue.index()) {
-          case 0: return true;
-          case 1: return std::get<bool>(lhs.mValue) == std::get<bool>(rhs.mValue);
-          case 2: return std::get<int64_t>(lhs.mValue) == std::get<int64_t>(rhs.mValue);
-          case 3: return std::get<double>(lhs.mValue) == std::get<double>(rhs.mValue);
-          case 4: return std::get<std::string>(lhs.mValue) == std::get<std::string>(rhs.mValue);
-          case 5: {
-            auto &a = std::get<jArray>(lhs.mValue);
-            auto &b = std::get<jArray>(rhs.mValue);
-            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
-          }
-          case 6: {
-            auto &a = std::get<jObject>(lhs.mValue);
-            auto &b = std::get<jObject>(rhs.mValue);
-            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
-          }
-          default: return false;
+        if (!std::string_view{p, end}.starts_with(literal)) {
+          return false;
+        }
+
+        p += literal.size();
+
+        int next = peek();
+
+        if (next != -1 && next != ',' && next != ']' && next != '}' && !std::isspace(next)) {
+          return false;
         }
+      } else if (Parser::_lex_number(*this, token) == 'u') {
+        return false;
       }
 
-      friend std::ostream & operator << (std::ostream &out, Json const &value) {
-        out << value.dump();
-        return out;
+      if (open.empty()) {
+        return true;
       }
+    }
 
-  };
+    return false;
+  }
+
+  inline std::optional<RawNumber> RawNumber::parse(std::string_view text) {
+    ParseState ps{text.data(), text.data() + text.size()};
+    std::string token;
+    char type = Parser::_lex_number(ps, token);
+
+    if (type == 'u' || ps.p != ps.end) {
+      return {};
+    }
+
+    RawNumber result;
+
+    result.mText = text;
+    result.mType = (type == 'f' || type == 'c') ? JsonType::Decimal : JsonType::Integer;
+
+    return result;
+  }
+
+  inline std::optional<double> RawNumber::_decimal() const {
+    ParseState ps{mText.data(), mText.data() + mText.size()};
+    std::string token;
+    jValue value;
+    char type = Parser::_lex_number(ps, token);
+
+    if (!Parser::_convert_number(token, type, value)) {
+      return {};
+    }
+
+    return std::get<double>(value);
+  }
+
+  // number as int64_t when it is an integer in range, as double otherwise,
+  // for stores that don't keep raw text. Raw integers beyond int64_t throw
+  // std::range_error and raw decimals are rounded to the nearest double.
+  inline std::variant<int64_t, double> number_value(Json const &value) {
+    if (auto integer = value.get<int64_t>()) {
+      return *integer;
+    }
+
+    if (auto decimal = value.get<double>()) {
+      return *decimal;
+    }
+
+    throw std::range_error("number out of range");
+  }
 
   template <typename T>
-  void json_to(jjson::Json const &json, T &out) {
-    auto const &values = std::get<jArray>(json.get_value());
+  bool json_to(jjson::Json const &json, T &out) {
+    auto const *values = std::get_if<jArray>(&json.get_value());
 
-    for (auto const &value: values) {
+    if (values == nullptr) {
+      return false;
+    }
+
+    if constexpr (requires { out.reserve(values->size()); }) {
+      out.reserve(out.size() + values->size());
+    }
+
+    for (auto const &value: *values) {
       auto item = value.get<typename T::value_type>();
       if (item) {
         out.emplace_back(std::move(item.value()));
       }
     }
+
+    return true;
   }
 
   template <JsonTypeConcept T>
@@ -715,14 +2177,23 @@ namespace jjson {
     out = std::get<T>(json.get_value());
   }
 
+  // through get<T>() so raw numbers convert too
   template <>
-  void json_to(jjson::Json const &json, int &out) {
-    out = static_cast<int>(std::get<int64_t>(json.get_value()));
+  inline void json_to(jjson::Json const &json, int &out) {
+    auto value = json.get<int>();
+    if (!value) {
+      throw std::runtime_error("invalid access");
+    }
+    out = *value;
   }
 
   template <>
-  void json_to(jjson::Json const &json, float &out) {
-    out = static_cast<float>(std::get<double>(json.get_value()));
+  inline void json_to(jjson::Json const &json, float &out) {
+    auto value = json.get<float>();
+    if (!value) {
+      throw std::runtime_error("invalid access");
+    }
+    out = *value;
   }
 
 }
@@ -0,0 +1,415 @@
+#pragma once
+
+#include "jjson/json.h"
+#include "jjson/pointer.h"
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jjson {
+
+  // Primitive in-place edits used by the patch operations. Every edit records
+  // its inverse, so a failed patch can be rolled back touching only the nodes
+  // it has changed.
+  class PatchJournal {
+
+    public:
+      bool add(Json &document, Pointer const &path, Json value) {
+        std::optional<Json> replaced;
+        auto location = _put(document, path, std::move(value), replaced);
+
+        if (!location) {
+          return false;
+        }
+
+        if (replaced) {
+          mEntries.push_back({Action::Assign, std::move(*location), std::move(*replaced)});
+        } else {
+          mEntries.push_back({Action::Erase, std::move(*location), {}});
+        }
+
+        return true;
+      }
+
+      bool remove(Json &document, Pointer const &path) {
+        if (path.empty()) {
+          return false;
+        }
+
+        auto value = _take(document, path);
+
+        if (!value) {
+          return false;
+        }
+
+        mEntries.push_back({Action::Insert, path, std::move(*value)});
+
+        return true;
+      }
+
+      bool replace(Json &document, Pointer const &path, Json value) {
+        Json *node = path.resolve(document);
+
+        if (node == nullptr) {
+          return false;
+        }
+
+        mEntries.push_back({Action::Assign, path, std::move(*node)});
+        *node = std::move(value);
+
+        return true;
+      }
+
+      // relocates the subtree without copying it
+      bool move(Json &document, Pointer const &from, Pointer const &path) {
+        if (from.empty()) {
+          return false;
+        }
+
+        auto value = _take(document, from);
+
+        if (!value) {
+          return false;
+        }
+
+        std::optional<Json> replaced;
+        auto location = _put(document, path, std::move(*value), replaced);
+
+        if (!location) {
+          _put(document, from, std::move(*value), replaced);
+          return false;
+        }
+
+        bool hasReplaced = replaced.has_value();
+
+        mEntries.push_back({Action::Move, std::move(*location), std::move(replaced).value_or(Json{}), from, hasReplaced});
+
+        return true;
+      }
+
+      void rollback(Json &document) {
+        std::optional<Json> replaced;
+
+        for (auto i = mEntries.rbegin(); i != mEntries.rend(); i++) {
+          switch (i->action) {
+            case Action::Insert:
+              _put(document, i->path, std::move(i->value), replaced);
+              break;
+            case Action::Erase:
+              _take(document, i->path);
+              break;
+            case Action::Assign:
+              *i->path.resolve(document) = std::move(i->value);
+              break;
+            case Action::Move: {
+              auto value = _take(document, i->path);
+              if (i->replaced) {
+                _put(document, i->path, std::move(i->value), replaced);
+              }
+              _put(document, i->from, std::move(*value), replaced);
+              break;
+            }
+          }
+        }
+
+        mEntries.clear();
+      }
+
+    private:
+      enum class Action {
+        Insert,
+        Erase,
+        Assign,
+        Move
+      };
+
+      struct Entry {
+        Action action;
+        Pointer path;
+        Json value;
+        Pointer from{};
+        bool replaced = false;
+      };
+
+      std::vector<Entry> mEntries;
+
+      // stores value at path and returns its concrete location; value is only
+      // consumed on success
+      static std::optional<Pointer> _put(Json &document, Pointer const &path, Json &&value, std::optional<Json> &replaced) {
+        replaced.reset();
+
+        if (path.empty()) {
+          replaced = std::move(document);
+          document = std::move(value);
+          return path;
+        }
+
+        Json *parent = path.parent().resolve(document);
+
+        if (parent == nullptr) {
+          return {};
+        }
+
+        if (parent->is_object()) {
+          auto &object = parent->get_or_throw<jObject>();
+          auto [i, inserted] = object.try_emplace(path.back());
+
+          if (!inserted) {
+            replaced = std::move(i->second);
+          }
+
+          i->second = std::move(value);
+
+          return path;
+        }
+
+        if (parent->is_array()) {
+          auto &array = parent->get_or_throw<jArray>();
+          std::size_t index = array.size();
+
+          if (path.back() != "-") {
+            auto token = Pointer::index(path.back());
+
+            if (!token || *token > array.size()) {
+              return {};
+            }
+
+            index = *token;
+          }
+
+          array.insert(array.begin() + index, std::move(value));
+
+          return path.parent() / index;
+        }
+
+        return {};
+      }
+
+      static std::optional<Json> _take(Json &document, Pointer const &path) {
+        if (path.empty()) {
+          return std::exchange(document, Json{});
+        }
+
+        Json *parent = path.parent().resolve(document);
+
+        if (parent == nullptr) {
+          return {};
+        }
+
+        if (parent->is_object()) {
+          auto &object = parent->get_or_throw<jObject>();
+
+          if (auto node = object.extract(path.back())) {
+            return std::move(node.mapped());
+          }
+        } else if (parent->is_array()) {
+          auto &array = parent->get_or_throw<jArray>();
+          auto index = Pointer::index(path.back());
+
+          if (index && *index < array.size()) {
+            Json value = std::move(array[*index]);
+            array.erase(array.begin() + *index);
+            return value;
+          }
+        }
+
+        return {};
+      }
+
+  };
+
+  // RFC 6902: applies the operations in place. Returns false and leaves the
+  // document unchanged if any operation fails.
+  inline bool apply_patch(Json &document, Json const &patch) {
+    if (!patch.is_array()) {
+      return false;
+    }
+
+    PatchJournal journal;
+
+    auto fail = [&]() {
+      journal.rollback(document);
+      return false;
+    };
+
+    for (auto const &operation : patch.get_or_throw<jArray>()) {
+      if (!operation.has("op") || !operation.has("path")) {
+        return fail();
+      }
+
+      auto op = operation["op"].get<std::string>();
+      auto pathStr = operation["path"].get<std::string>();
+
+      if (!op || !pathStr) {
+        return fail();
+      }
+
+      auto path = Pointer::parse(*pathStr);
+
+      if (!path) {
+        return fail();
+      }
+
+      std::optional<Pointer> from;
+
+      if (*op == "move" || *op == "copy") {
+        if (!operation.has("from")) {
+          return fail();
+        }
+
+        if (auto fromStr = operation["from"].get<std::string>()) {
+          from = Pointer::parse(*fromStr);
+        }
+
+        if (!from) {
+          return fail();
+        }
+      } else if (*op != "remove" && !operation.has("value")) {
+        return fail();
+      }
+
+      bool ok = false;
+
+      if (*op == "add") {
+        ok = journal.add(document, *path, operation["value"]);
+      } else if (*op == "remove") {
+        ok = journal.remove(document, *path);
+      } else if (*op == "replace") {
+        ok = journal.replace(document, *path, operation["value"]);
+      } else if (*op == "move") {
+        if (*from == *path) {
+          ok = from->resolve(document) != nullptr;
+        } else if (!path->starts_with(*from)) {
+          ok = journal.move(document, *from, *path);
+        }
+      } else if (*op == "copy") {
+        if (auto const *value = from->resolve(std::as_const(document))) {
+          ok = journal.add(document, *path, *value);
+        }
+      } else if (*op == "test") {
+        auto const *value = path->resolve(std::as_const(document));
+        ok = value != nullptr && *value == operation["value"];
+      }
+
+      if (!ok) {
+        return fail();
+      }
+    }
+
+    return true;
+  }
+
+  // RFC 7396: null members remove keys, objects merge recursively and any
+  // other value replaces the target in place.
+  inline void apply_merge_patch(Json &document, Json const &patch) {
+    if (!patch.is_object()) {
+      document = patch;
+      return;
+    }
+
+    if (!document.is_object()) {
+      document = jObject{};
+    }
+
+    auto &object = document.get_or_throw<jObject>();
+
+    for (auto const &[key, value] : patch.get_or_throw<jObject>()) {
+      if (value.is_null()) {
+        object.erase(key);
+      } else {
+        apply_merge_patch(object[key], value);
+      }
+    }
+  }
+
+  namespace detail {
+
+    inline Json patch_operation(char const *op, Pointer const &path) {
+      return Json{
+        {"op", op},
+        {"path", path.str()}};
+    }
+
+    inline Json patch_operation(char const *op, Pointer const &path, Json const &value) {
+      return Json{
+        {"op", op},
+        {"path", path.str()},
+        {"value", value}};
+    }
+
+    inline void diff(Json const &source, Json const &target, Pointer const &path, jArray &out) {
+      if (source == target) {
+        return;
+      }
+
+      if (source.is_object() && target.is_object()) {
+        auto const &a = source.get_or_throw<jObject>();
+        auto const &b = target.get_or_throw<jObject>();
+
+        for (auto const &[key, value] : a) {
+          if (auto i = b.find(key); i == b.end()) {
+            out.push_back(patch_operation("remove", path / key));
+          } else {
+            diff(value, i->second, path / key, out);
+          }
+        }
+
+        for (auto const &[key, value] : b) {
+          if (!a.contains(key)) {
+            out.push_back(patch_operation("add", path / key, value));
+          }
+        }
+
+        return;
+      }
+
+      if (source.is_array() && target.is_array()) {
+        auto const &a = source.get_or_throw<jArray>();
+        auto const &b = target.get_or_throw<jArray>();
+
+        // only the range between the common prefix and suffix is edited
+        std::size_t prefix = 0;
+        std::size_t suffix = 0;
+
+        while (prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix]) {
+          prefix++;
+        }
+
+        while (suffix < a.size() - prefix && suffix < b.size() - prefix &&
+            a[a.size() - suffix - 1] == b[b.size() - suffix - 1]) {
+          suffix++;
+        }
+
+        std::size_t n = a.size() - prefix - suffix;
+        std::size_t m = b.size() - prefix - suffix;
+
+        for (std::size_t i = 0; i < std::min(n, m); i++) {
+          diff(a[prefix + i], b[prefix + i], path / (prefix + i), out);
+        }
+
+        for (std::size_t i = n; i > m; i--) {
+          out.push_back(patch_operation("remove", path / (prefix + i - 1)));
+        }
+
+        for (std::size_t i = n; i < m; i++) {
+          out.push_back(patch_operation("add", path / (prefix + i), b[prefix + i]));
+        }
+
+        return;
+      }
+
+      out.push_back(patch_operation("replace", path, target));
+    }
+
+  }
+
+  // RFC 6902 patch that turns source into target
+  inline Json diff(Json const &source, Json const &target) {
+    jArray operations;
+    detail::diff(source, target, {}, operations);
+    return Json{std::move(operations)};
+  }
+
+}
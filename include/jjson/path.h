@@ -0,0 +1,1066 @@
+#pragma once
+
+#include "jjson/json.h"
+#include "jjson/projection.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace jjson {
+
+  // Compiled JSONPath, the RFC 9535 subset of:
+  //
+  //   $.store.book[0].title     names and indexes (negative from the end)
+  //   $['store']["book"][-1]    bracketed names
+  //   $.store.*  $[*]           wildcards
+  //   $..price  $..[0]          descendants
+  //   $.items[1:10:2]           slices
+  //   $.items[0, 2, 'x']        several selectors
+  //   $.items[?@.price > 10 && @.type == 'donut']
+  //
+  // Filters combine comparisons (==, !=, <, <=, >, >=) between literals and
+  // singular queries on the current value (@.a.b, @['a'][0]) with &&, || and
+  // !, and a query alone tests that the value exists. As in the RFC numbers
+  // compare by value, strings by code point and values of different types
+  // are only unequal.
+  //
+  // select() runs on a Json. scan() runs over the text: values no selector
+  // can reach are skipped like in a projection (checking brackets, literals
+  // and numbers but not escapes or separators), and only the matches are
+  // parsed, along with the members a filter reads.
+  class JsonPath {
+
+    // step of a singular query, a name or an index
+    using Step = std::variant<std::string, int64_t>;
+
+    enum class Op {
+      Or,
+      And,
+      Not,
+      Exists,
+      Equal,
+      NotEqual,
+      Less,
+      LessEqual,
+      Greater,
+      GreaterEqual
+    };
+
+    struct Operand {
+      std::optional<std::vector<Step>> query; // relative to @, literal otherwise
+      Json literal;
+    };
+
+    struct Expression {
+      Op op = Op::Exists;
+      std::vector<Expression> operands; // of Or, And and Not
+      Operand lhs; // of Exists and the comparisons
+      Operand rhs;
+    };
+
+    struct Slice {
+      std::optional<int64_t> start;
+      std::optional<int64_t> end;
+      int64_t step = 1;
+    };
+
+    struct Selector {
+      enum class Kind {
+        Name,
+        Wildcard,
+        Index,
+        Slice,
+        Filter
+      };
+
+      Kind kind = Kind::Index;
+      std::string name;
+      int64_t index = 0;
+      Slice slice;
+      std::optional<Expression> filter;
+      Projection projection; // members the filter reads
+    };
+
+    struct Segment {
+      bool descendant = false;
+      std::vector<Selector> selectors;
+    };
+
+    struct Scan {
+      Parser parser;
+      std::vector<Json> result;
+      std::string key;
+      Json scratch;
+      std::deque<std::vector<std::size_t>> states; // per depth, reused across containers
+    };
+
+    public:
+      static std::optional<JsonPath> compile(std::string_view path) {
+        JsonPath result;
+
+        if (!path.starts_with('$')) {
+          return {};
+        }
+
+        path.remove_prefix(1);
+
+        while (true) {
+          _skip(path);
+
+          if (path.empty()) {
+            break;
+          }
+
+          auto segment = _segment(path);
+
+          if (!segment) {
+            return {};
+          }
+
+          result.mSegments.push_back(std::move(*segment));
+        }
+
+        return result;
+      }
+
+      // values selected in document
+      std::vector<Json const *> select(Json const &document) const {
+        std::vector<Json const *> result;
+
+        _select(document, 0, result);
+
+        return result;
+      }
+
+      // values selected in data, in source order (matches nested in another
+      // match follow select()). Returns nothing if data is invalid where it
+      // is read.
+      std::optional<std::vector<Json>> scan(std::string_view data) const {
+        Scan scan;
+
+        scan.parser.mState = ParseState{data.data(), data.data() + data.size()};
+
+        scan.states.push_back({0});
+
+        if (!_scan(scan, 0)) {
+          return {};
+        }
+
+        return std::move(scan.result);
+      }
+
+    private:
+      std::vector<Segment> mSegments;
+
+      JsonPath() = default;
+
+      void _select(Json const &node, std::size_t k, std::vector<Json const *> &result) const {
+        if (k == mSegments.size()) {
+          result.push_back(&node);
+          return;
+        }
+
+        auto const &segment = mSegments[k];
+
+        for (auto const &selector : segment.selectors) {
+          _apply(selector, node, [&](Json const &child) {
+            _select(child, k + 1, result);
+          });
+        }
+
+        if (segment.descendant) {
+          _children(node, [&](Json const &child) {
+            _select(child, k, result);
+          });
+        }
+      }
+
+      template <typename F>
+      static void _children(Json const &node, F &&f) {
+        if (node.is_array()) {
+          for (auto const &child : node.get_or_throw<jArray>()) {
+            f(child);
+          }
+        } else if (node.is_object()) {
+          for (auto const &[key, child] : node.get_or_throw<jObject>()) {
+            f(child);
+          }
+        }
+      }
+
+      template <typename F>
+      static void _apply(Selector const &selector, Json const &node, F &&f) {
+        switch (selector.kind) {
+          case Selector::Kind::Name:
+            if (node.is_object()) {
+              auto const &object = node.get_or_throw<jObject>();
+
+              if (auto i = object.find(selector.name); i != object.end()) {
+                f(i->second);
+              }
+            }
+            break;
+          case Selector::Kind::Wildcard:
+            _children(node, f);
+            break;
+          case Selector::Kind::Index:
+            if (node.is_array()) {
+              if (auto const *child = _element(node.get_or_throw<jArray>(), selector.index)) {
+                f(*child);
+              }
+            }
+            break;
+          case Selector::Kind::Slice:
+            if (node.is_array()) {
+              auto const &array = node.get_or_throw<jArray>();
+              auto step = selector.slice.step;
+              auto [lower, upper] = _bounds(selector.slice, static_cast<int64_t>(array.size()));
+
+              // the steps stop before overflowing
+              if (step > 0) {
+                for (int64_t i = lower; i < upper; i = upper - i > step ? i + step : upper) {
+                  f(array[static_cast<std::size_t>(i)]);
+                }
+              } else if (step < 0) {
+                for (int64_t i = upper; lower < i; i = i - lower > -step ? i + step : lower) {
+                  f(array[static_cast<std::size_t>(i)]);
+                }
+              }
+            }
+            break;
+          case Selector::Kind::Filter:
+            _children(node, [&](Json const &child) {
+              if (_test(*selector.filter, child)) {
+                f(child);
+              }
+            });
+            break;
+        }
+      }
+
+      static Json const * _element(jArray const &array, int64_t index) {
+        auto size = static_cast<int64_t>(array.size());
+
+        if (index < 0) {
+          index += size;
+        }
+
+        if (index < 0 || index >= size) {
+          return nullptr;
+        }
+
+        return &array[static_cast<std::size_t>(index)];
+      }
+
+      // selected indexes, as in RFC 9535: [lower, upper) going forward and
+      // (lower, upper] going back
+      static std::pair<int64_t, int64_t> _bounds(Slice const &slice, int64_t length) {
+        auto normalize = [&](int64_t index) {
+          return index >= 0 ? index : length + index;
+        };
+
+        if (slice.step >= 0) {
+          return {
+            std::clamp<int64_t>(normalize(slice.start.value_or(0)), 0, length),
+            std::clamp<int64_t>(slice.end ? normalize(*slice.end) : length, 0, length)};
+        }
+
+        return {
+          std::clamp<int64_t>(slice.end ? normalize(*slice.end) : -1, -1, length - 1),
+          std::clamp<int64_t>(slice.start ? normalize(*slice.start) : length - 1, -1, length - 1)};
+      }
+
+      static bool _test(Expression const &expression, Json const &current) {
+        switch (expression.op) {
+          case Op::Or:
+            return std::any_of(expression.operands.begin(), expression.operands.end(), [&](Expression const &operand) {
+              return _test(operand, current);
+            });
+          case Op::And:
+            return std::all_of(expression.operands.begin(), expression.operands.end(), [&](Expression const &operand) {
+              return _test(operand, current);
+            });
+          case Op::Not:
+            return !_test(expression.operands.front(), current);
+          case Op::Exists:
+            return _resolve(expression.lhs, current) != nullptr;
+          default:
+            return _compare(expression.op, _resolve(expression.lhs, current), _resolve(expression.rhs, current));
+        }
+      }
+
+      // nullptr when the query selects nothing
+      static Json const * _resolve(Operand const &operand, Json const &current) {
+        if (!operand.query) {
+          return &operand.literal;
+        }
+
+        Json const *value = &current;
+
+        for (auto const &step : *operand.query) {
+          if (auto const *name = std::get_if<std::string>(&step)) {
+            if (!value->is_object()) {
+              return nullptr;
+            }
+
+            auto const &object = value->get_or_throw<jObject>();
+            auto i = object.find(*name);
+
+            if (i == object.end()) {
+              return nullptr;
+            }
+
+            value = &i->second;
+          } else {
+            if (!value->is_array() || (value = _element(value->get_or_throw<jArray>(), std::get<int64_t>(step))) == nullptr) {
+              return nullptr;
+            }
+          }
+        }
+
+        return value;
+      }
+
+      static bool _compare(Op op, Json const *lhs, Json const *rhs) {
+        switch (op) {
+          case Op::Equal:
+            return _equal(lhs, rhs);
+          case Op::NotEqual:
+            return !_equal(lhs, rhs);
+          case Op::Less:
+            return _less(lhs, rhs);
+          case Op::LessEqual:
+            return _less(lhs, rhs) || _equal(lhs, rhs);
+          case Op::Greater:
+            return _less(rhs, lhs);
+          case Op::GreaterEqual:
+            return _less(rhs, lhs) || _equal(lhs, rhs);
+          default:
+            return false;
+        }
+      }
+
+      static bool _is_number(Json const &value) {
+        return value.is_integer() || value.is_decimal();
+      }
+
+      // sign of lhs - rhs, integers compared exactly
+      static int _order(Json const &lhs, Json const &rhs) {
+        auto a = lhs.get<int64_t>();
+        auto b = rhs.get<int64_t>();
+
+        if (a && b) {
+          return (*a > *b) - (*a < *b);
+        }
+
+        auto decimal = [](Json const &value, std::optional<int64_t> integer) {
+          return integer ? static_cast<double>(*integer) : value.get<double>().value_or(std::numeric_limits<double>::quiet_NaN());
+        };
+
+        double x = decimal(lhs, a);
+        double y = decimal(rhs, b);
+
+        return (x > y) - (x < y);
+      }
+
+      // two missing values are equal
+      static bool _equal(Json const *lhs, Json const *rhs) {
+        if (lhs == nullptr || rhs == nullptr) {
+          return lhs == rhs;
+        }
+
+        if (_is_number(*lhs) && _is_number(*rhs)) {
+          return _order(*lhs, *rhs) == 0;
+        }
+
+        return *lhs == *rhs;
+      }
+
+      static bool _less(Json const *lhs, Json const *rhs) {
+        if (lhs == nullptr || rhs == nullptr) {
+          return false;
+        }
+
+        if (_is_number(*lhs) && _is_number(*rhs)) {
+          return _order(*lhs, *rhs) < 0;
+        }
+
+        if (lhs->is_text() && rhs->is_text()) {
+          return lhs->get_or_throw<std::string>() < rhs->get_or_throw<std::string>();
+        }
+
+        return false;
+      }
+
+      // the value at ps is reached in the segments k of scan.states[depth]
+      // (k == size() for a match)
+      bool _scan(Scan &scan, std::size_t depth) const {
+        auto &ps = scan.parser.mState;
+        auto const &states = scan.states[depth];
+
+        ps.skip_space();
+
+        if (states.empty()) {
+          return ps.skip_value();
+        }
+
+        if (std::find(states.begin(), states.end(), mSegments.size()) != states.end()) {
+          return _take(scan, states);
+        }
+
+        int c = ps.peek();
+
+        // an empty document is null, as in a full parse
+        if (c == -1 && depth == 0) {
+          return true;
+        }
+
+        if (c != '[' && c != '{') {
+          return ps.skip_value();
+        }
+
+        bool object = c == '{';
+        std::optional<std::size_t> length;
+
+        if (scan.states.size() == depth + 1) {
+          scan.states.emplace_back();
+        }
+
+        auto &children = scan.states[depth + 1];
+
+        ps.get();
+
+        if (!object && _needs_length(states)) {
+          if (!(length = _length(ps))) {
+            return false;
+          }
+        }
+
+        for (std::size_t index = 0;;) {
+          ps.skip_space();
+          c = ps.peek();
+
+          if (c == (object ? '}' : ']')) {
+            ps.get();
+            return true;
+          }
+
+          if (c == ',') {
+            ps.get();
+            continue;
+          }
+
+          if (c == -1 || c == ']' || c == '}') {
+            return false;
+          }
+
+          if (object) {
+            scan.key.clear();
+
+            if (c != '"' || !ps.read_string(scan.key)) {
+              return false;
+            }
+
+            ps.skip_space();
+
+            if (ps.get() != ':') {
+              return false;
+            }
+
+            ps.skip_space();
+
+            if (ps.peek() == -1) {
+              return false;
+            }
+          }
+
+          children.clear();
+
+          for (auto k : states) {
+            auto const &segment = mSegments[k];
+
+            for (auto const &selector : segment.selectors) {
+              bool selected;
+
+              if (selector.kind == Selector::Kind::Filter) {
+                if (!_filter(scan, selector, selected)) {
+                  return false;
+                }
+              } else {
+                selected = _matches(selector, object ? &scan.key : nullptr, index, length);
+              }
+
+              if (selected) {
+                children.push_back(k + 1);
+              }
+            }
+
+            if (segment.descendant) {
+              children.push_back(k);
+            }
+          }
+
+          if (!_scan(scan, depth + 1)) {
+            return false;
+          }
+
+          index++;
+        }
+      }
+
+      // parses a match, the other states continue on the parsed value
+      bool _take(Scan &scan, std::vector<std::size_t> const &states) const {
+        Json value;
+
+        if (!scan.parser._parse(value, ParseFilter{})) {
+          return false;
+        }
+
+        std::vector<Json const *> matches;
+
+        for (auto k : states) {
+          _select(value, k, matches);
+        }
+
+        if (matches.size() == 1) {
+          scan.result.push_back(std::move(value));
+          return true;
+        }
+
+        for (auto const *match : matches) {
+          scan.result.push_back(*match);
+        }
+
+        return true;
+      }
+
+      // parses the members read by the filter and tests them, then rewinds
+      bool _filter(Scan &scan, Selector const &selector, bool &selected) const {
+        auto &ps = scan.parser.mState;
+        const char *begin = ps.p;
+
+        if (!scan.parser._parse(scan.scratch, selector.projection.filter())) {
+          return false;
+        }
+
+        ps.p = begin;
+        selected = _test(*selector.filter, scan.scratch);
+
+        return true;
+      }
+
+      static bool _matches(Selector const &selector, std::string const *key, std::size_t index, std::optional<std::size_t> length) {
+        auto i = static_cast<int64_t>(index);
+
+        switch (selector.kind) {
+          case Selector::Kind::Name:
+            return key != nullptr && *key == selector.name;
+          case Selector::Kind::Wildcard:
+            return true;
+          case Selector::Kind::Index:
+            return key == nullptr && (selector.index >= 0 ? i == selector.index : length && i == static_cast<int64_t>(*length) + selector.index);
+          case Selector::Kind::Slice: {
+            auto const &slice = selector.slice;
+
+            if (key != nullptr || slice.step == 0) {
+              return false;
+            }
+
+            if (!length) {
+              auto start = slice.start.value_or(0);
+              return i >= start && (!slice.end || i < *slice.end) && (i - start) % slice.step == 0;
+            }
+
+            auto [lower, upper] = _bounds(slice, static_cast<int64_t>(*length));
+
+            if (slice.step > 0) {
+              return lower <= i && i < upper && (i - lower) % slice.step == 0;
+            }
+
+            return lower < i && i <= upper && (upper - i) % -slice.step == 0;
+          }
+          default:
+            return false;
+        }
+      }
+
+      // selectors counting from the end of an array need its length
+      bool _needs_length(std::vector<std::size_t> const &states) const {
+        for (auto k : states) {
+          for (auto const &selector : mSegments[k].selectors) {
+            auto const &slice = selector.slice;
+
+            if ((selector.kind == Selector::Kind::Index && selector.index < 0) ||
+                (selector.kind == Selector::Kind::Slice && (slice.step < 0 || slice.start.value_or(0) < 0 || slice.end.value_or(0) < 0))) {
+              return true;
+            }
+          }
+        }
+        return false;
+      }
+
+      // number of elements of the array at ps, without moving
+      static std::optional<std::size_t> _length(ParseState &ps) {
+        const char *begin = ps.p;
+        std::size_t length = 0;
+
+        while (true) {
+          ps.skip_space();
+          int c = ps.peek();
+
+          if (c == ']') {
+            break;
+          }
+
+          if (c == ',') {
+            ps.get();
+            continue;
+          }
+
+          if (c == -1 || c == '}' || !ps.skip_value()) {
+            return {};
+          }
+
+          length++;
+        }
+
+        ps.p = begin;
+
+        return length;
+      }
+
+      static void _skip(std::string_view &in) {
+        while (!in.empty() && std::isspace(static_cast<unsigned char>(in.front()))) {
+          in.remove_prefix(1);
+        }
+      }
+
+      // skips spaces, then token if it is next
+      static bool _consume(std::string_view &in, std::string_view token) {
+        _skip(in);
+
+        if (!in.starts_with(token)) {
+          return false;
+        }
+
+        in.remove_prefix(token.size());
+
+        return true;
+      }
+
+      static std::optional<Segment> _segment(std::string_view &in) {
+        Segment segment;
+
+        if (in.starts_with("..")) {
+          in.remove_prefix(2);
+          segment.descendant = true;
+
+          if (in.starts_with('[')) {
+            return _brackets(in, std::move(segment));
+          }
+        } else if (in.starts_with('.')) {
+          in.remove_prefix(1);
+        } else if (in.starts_with('[')) {
+          return _brackets(in, std::move(segment));
+        } else {
+          return {};
+        }
+
+        if (in.starts_with('*')) {
+          in.remove_prefix(1);
+          segment.selectors.emplace_back().kind = Selector::Kind::Wildcard;
+        } else if (auto name = _name(in)) {
+          auto &selector = segment.selectors.emplace_back();
+
+          selector.kind = Selector::Kind::Name;
+          selector.name = std::move(*name);
+        } else {
+          return {};
+        }
+
+        return segment;
+      }
+
+      static std::optional<Segment> _brackets(std::string_view &in, Segment segment) {
+        in.remove_prefix(1); // skip '['
+
+        do {
+          auto selector = _selector(in);
+
+          if (!selector) {
+            return {};
+          }
+
+          segment.selectors.push_back(std::move(*selector));
+        } while (_consume(in, ","));
+
+        if (!_consume(in, "]")) {
+          return {};
+        }
+
+        return segment;
+      }
+
+      static std::optional<Selector> _selector(std::string_view &in) {
+        Selector selector;
+
+        _skip(in);
+
+        if (in.starts_with('\'') || in.starts_with('"')) {
+          auto name = _quoted(in);
+
+          if (!name) {
+            return {};
+          }
+
+          selector.kind = Selector::Kind::Name;
+          selector.name = std::move(*name);
+        } else if (_consume(in, "*")) {
+          selector.kind = Selector::Kind::Wildcard;
+        } else if (_consume(in, "?")) {
+          if (!(selector.filter = _or(in))) {
+            return {};
+          }
+
+          selector.kind = Selector::Kind::Filter;
+          _project(*selector.filter, selector.projection);
+        } else {
+          auto start = _integer(in);
+
+          if (!_consume(in, ":")) {
+            if (!start) {
+              return {};
+            }
+
+            selector.index = *start;
+            return selector;
+          }
+
+          auto &slice = selector.slice;
+
+          selector.kind = Selector::Kind::Slice;
+          slice.start = start;
+          _skip(in);
+          slice.end = _integer(in);
+
+          if (_consume(in, ":")) {
+            _skip(in);
+
+            if (auto step = _integer(in)) {
+              slice.step = *step;
+            }
+          }
+
+          if (slice.step == std::numeric_limits<int64_t>::min()) {
+            return {};
+          }
+        }
+
+        return selector;
+      }
+
+      static std::optional<int64_t> _integer(std::string_view &in) {
+        // the RFC has no leading zeros and no -0
+        bool negative = in.starts_with('-');
+        std::string_view digits = in.substr(negative ? 1 : 0);
+
+        if (digits.starts_with('0') && (negative || (digits.size() > 1 && std::isdigit(static_cast<unsigned char>(digits[1]))))) {
+          return {};
+        }
+
+        int64_t value;
+        auto [end, error] = std::from_chars(in.data(), in.data() + in.size(), value);
+
+        if (error != std::errc{}) {
+          return {};
+        }
+
+        in.remove_prefix(static_cast<std::size_t>(end - in.data()));
+
+        return value;
+      }
+
+      // member name shorthand, as in .name
+      static std::optional<std::string> _name(std::string_view &in) {
+        std::size_t size = 0;
+
+        while (size < in.size()) {
+          auto c = static_cast<unsigned char>(in[size]);
+
+          if (!(std::isalpha(c) || c == '_' || c >= 0x80 || (size > 0 && std::isdigit(c)))) {
+            break;
+          }
+
+          size++;
+        }
+
+        if (size == 0) {
+          return {};
+        }
+
+        std::string result{in.substr(0, size)};
+
+        in.remove_prefix(size);
+
+        return result;
+      }
+
+      // 'single' or "double" quoted string, with JSON escapes and \'
+      static std::optional<std::string> _quoted(std::string_view &in) {
+        char quote = in.front();
+        std::string literal{'"'}; // rewritten with double quotes for read_string
+        std::size_t i = 1;
+
+        for (; i < in.size() && in[i] != quote; i++) {
+          if (in[i] == '\\' && i + 1 < in.size()) {
+            if (in[i + 1] == '\'') {
+              literal += in[++i];
+            } else {
+              literal += in[i];
+              literal += in[++i];
+            }
+            continue;
+          }
+
+          if (in[i] == '"') {
+            literal += '\\';
+          }
+
+          literal += in[i];
+        }
+
+        if (i >= in.size()) {
+          return {};
+        }
+
+        literal += '"';
+        in.remove_prefix(i + 1);
+
+        std::string result;
+        ParseState ps{literal.data(), literal.data() + literal.size()};
+
+        if (!ps.read_string(result)) {
+          return {};
+        }
+
+        return result;
+      }
+
+      static std::optional<Expression> _or(std::string_view &in) {
+        return _list(in, Op::Or, "||", _and);
+      }
+
+      static std::optional<Expression> _and(std::string_view &in) {
+        return _list(in, Op::And, "&&", _unary);
+      }
+
+      static std::optional<Expression> _list(std::string_view &in, Op op, std::string_view separator,
+          std::optional<Expression> (*operand)(std::string_view &)) {
+        auto first = operand(in);
+
+        if (!first || !_consume(in, separator)) {
+          return first;
+        }
+
+        Expression result;
+
+        result.op = op;
+
+        result.operands.push_back(std::move(*first));
+
+        do {
+          auto next = operand(in);
+
+          if (!next) {
+            return {};
+          }
+
+          result.operands.push_back(std::move(*next));
+        } while (_consume(in, separator));
+
+        return result;
+      }
+
+      static std::optional<Expression> _unary(std::string_view &in) {
+        if (_consume(in, "!")) {
+          auto operand = _unary(in);
+
+          if (!operand) {
+            return {};
+          }
+
+          Expression result;
+
+          result.op = Op::Not;
+
+          result.operands.push_back(std::move(*operand));
+
+          return result;
+        }
+
+        if (_consume(in, "(")) {
+          auto result = _or(in);
+
+          if (!result || !_consume(in, ")")) {
+            return {};
+          }
+
+          return result;
+        }
+
+        auto lhs = _operand(in);
+
+        if (!lhs) {
+          return {};
+        }
+
+        static constexpr std::pair<std::string_view, Op> comparisons[] = {
+          {"==", Op::Equal}, {"!=", Op::NotEqual}, {"<=", Op::LessEqual},
+          {">=", Op::GreaterEqual}, {"<", Op::Less}, {">", Op::Greater}};
+
+        for (auto const &[token, op] : comparisons) {
+          if (_consume(in, token)) {
+            auto rhs = _operand(in);
+
+            if (!rhs) {
+              return {};
+            }
+
+            Expression result;
+
+            result.op = op;
+            result.lhs = std::move(*lhs);
+            result.rhs = std::move(*rhs);
+
+            return result;
+          }
+        }
+
+        // a literal alone is not a test
+        if (!lhs->query) {
+          return {};
+        }
+
+        Expression result;
+
+        result.lhs = std::move(*lhs);
+
+        return result;
+      }
+
+      static std::optional<Operand> _operand(std::string_view &in) {
+        Operand result;
+
+        _skip(in);
+
+        if (in.starts_with('@')) {
+          auto &query = result.query.emplace();
+
+          in.remove_prefix(1);
+
+          while (true) {
+            if (in.starts_with('.') && !in.starts_with("..")) {
+              in.remove_prefix(1);
+
+              auto name = _name(in);
+
+              if (!name) {
+                return {};
+              }
+
+              query.emplace_back(std::move(*name));
+            } else if (in.starts_with('[')) {
+              in.remove_prefix(1);
+              _skip(in);
+
+              if (in.starts_with('\'') || in.starts_with('"')) {
+                auto name = _quoted(in);
+
+                if (!name) {
+                  return {};
+                }
+
+                query.emplace_back(std::move(*name));
+              } else if (auto index = _integer(in)) {
+                query.emplace_back(*index);
+              } else {
+                return {};
+              }
+
+              if (!_consume(in, "]")) {
+                return {};
+              }
+            } else {
+              break;
+            }
+          }
+        } else if (in.starts_with('\'') || in.starts_with('"')) {
+          auto text = _quoted(in);
+
+          if (!text) {
+            return {};
+          }
+
+          result.literal = Json{std::move(*text)};
+        } else {
+          std::size_t size = 0;
+
+          while (size < in.size() && (std::isalnum(static_cast<unsigned char>(in[size])) ||
+                in[size] == '-' || in[size] == '+' || in[size] == '.')) {
+            size++;
+          }
+
+          auto literal = Json::parse(in.substr(0, size));
+
+          if (size == 0 || !literal || literal->is_array() || literal->is_object() || literal->is_text()) {
+            return {};
+          }
+
+          result.literal = std::move(*literal);
+          in.remove_prefix(size);
+        }
+
+        return result;
+      }
+
+      // the leading names of the queries of the filter, as a projection. A
+      // query that is empty or starts with an index keeps the whole value.
+      static void _project(Expression const &expression, Projection &projection) {
+        for (auto const &operand : expression.operands) {
+          _project(operand, projection);
+        }
+
+        for (auto const *operand : {&expression.lhs, &expression.rhs}) {
+          if (!operand->query) {
+            continue;
+          }
+
+          std::vector<std::string> keys;
+
+          for (auto const &step : *operand->query) {
+            auto const *name = std::get_if<std::string>(&step);
+
+            if (name == nullptr) {
+              break;
+            }
+
+            keys.push_back(*name);
+          }
+
+          projection.add(keys);
+        }
+      }
+
+  };
+
+}
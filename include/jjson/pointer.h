@@ -0,0 +1,188 @@
+#pragma once
+
+#include "jjson/json.h"
+
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jjson {
+
+  // RFC 6901 JSON Pointer, e.g. "/items/item/0/name"
+  class Pointer {
+
+    public:
+      Pointer() = default;
+
+      Pointer(std::vector<std::string> tokens)
+        : mTokens{std::move(tokens)} {
+      }
+
+      static std::optional<Pointer> parse(std::string_view path) {
+        Pointer result;
+
+        if (path.empty()) {
+          return result;
+        }
+
+        if (path.front() != '/') {
+          return {};
+        }
+
+        path.remove_prefix(1);
+
+        while (true) {
+          auto pos = path.find('/');
+          auto token = _unescape(path.substr(0, pos));
+
+          if (!token) {
+            return {};
+          }
+
+          result.mTokens.push_back(std::move(token.value()));
+
+          if (pos == std::string_view::npos) {
+            break;
+          }
+
+          path.remove_prefix(pos + 1);
+        }
+
+        return result;
+      }
+
+      std::vector<std::string> const & tokens() const {
+        return mTokens;
+      }
+
+      bool empty() const {
+        return mTokens.empty();
+      }
+
+      std::string const & back() const {
+        return mTokens.back();
+      }
+
+      Pointer parent() const {
+        return Pointer{{mTokens.begin(), mTokens.end() - 1}};
+      }
+
+      Pointer operator / (std::string token) const {
+        Pointer result{*this};
+        result.mTokens.push_back(std::move(token));
+        return result;
+      }
+
+      Pointer operator / (std::size_t index) const {
+        return *this / std::to_string(index);
+      }
+
+      bool starts_with(Pointer const &prefix) const {
+        return prefix.mTokens.size() <= mTokens.size() &&
+          std::equal(prefix.mTokens.begin(), prefix.mTokens.end(), mTokens.begin());
+      }
+
+      std::string str() const {
+        std::string result;
+
+        for (auto const &token : mTokens) {
+          result += '/';
+
+          for (char c : token) {
+            if (c == '~') {
+              result += "~0";
+            } else if (c == '/') {
+              result += "~1";
+            } else {
+              result += c;
+            }
+          }
+        }
+
+        return result;
+      }
+
+      // array index as defined by RFC 6901 (no sign, no leading zeros)
+      static std::optional<std::size_t> index(std::string const &token) {
+        if (token.empty() || (token.size() > 1 && token.front() == '0')) {
+          return {};
+        }
+
+        std::size_t value = 0;
+        auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+
+        if (ec != std::errc{} || ptr != token.data() + token.size()) {
+          return {};
+        }
+
+        return value;
+      }
+
+      Json * resolve(Json &root) const {
+        Json *node = &root;
+
+        for (auto const &token : mTokens) {
+          node = _child(*node, token);
+
+          if (node == nullptr) {
+            return nullptr;
+          }
+        }
+
+        return node;
+      }
+
+      Json const * resolve(Json const &root) const {
+        return resolve(const_cast<Json &>(root));
+      }
+
+      bool operator == (Pointer const &) const = default;
+
+    private:
+      std::vector<std::string> mTokens;
+
+      static std::optional<std::string> _unescape(std::string_view token) {
+        std::string result;
+
+        result.reserve(token.size());
+
+        for (std::size_t i = 0; i < token.size(); i++) {
+          if (token[i] != '~') {
+            result += token[i];
+          } else if (i + 1 < token.size() && token[i + 1] == '0') {
+            result += '~';
+            i++;
+          } else if (i + 1 < token.size() && token[i + 1] == '1') {
+            result += '/';
+            i++;
+          } else {
+            return {};
+          }
+        }
+
+        return result;
+      }
+
+      static Json * _child(Json &node, std::string const &token) {
+        if (node.is_object()) {
+          auto &object = node.get_or_throw<jObject>();
+
+          if (auto i = object.find(token); i != object.end()) {
+            return &i->second;
+          }
+        } else if (node.is_array()) {
+          auto &array = node.get_or_throw<jArray>();
+
+          if (auto index = Pointer::index(token); index && *index < array.size()) {
+            return &array[*index];
+          }
+        }
+
+        return nullptr;
+      }
+
+  };
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "jjson/json.h"
+
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace jjson {
+
+  // Set of member paths kept by Json::parse(data, projection). Paths are dot
+  // separated keys ("items.item.id"); arrays are traversed transparently, so
+  // the path applies to every element. Everything outside the selected paths
+  // is skipped by the scanner without allocating nodes or strings. Skipped
+  // members are checked less than parsed ones: brackets must match and
+  // literals and numbers be well formed, but escapes in strings and the
+  // commas and colons between values are not validated.
+  class Projection {
+
+    struct Node {
+      bool leaf = false; // keeps the whole subtree
+      std::unordered_map<std::string, std::size_t> children;
+    };
+
+    public:
+      class Filter {
+
+        public:
+          Filter() = default;
+
+          constexpr bool begin(JsonType) const {
+            return true;
+          }
+
+          constexpr bool end(Json const &) const {
+            return true;
+          }
+
+          Filter member(std::string const &key) const {
+            if (mNode == nullptr) {
+              return {};
+            }
+
+            if (auto i = mNode->children.find(key); i != mNode->children.end()) {
+              return _at(i->second);
+            }
+
+            return Filter{nullptr, nullptr, true};
+          }
+
+          Filter element(std::size_t) const {
+            return *this;
+          }
+
+          bool skip() const {
+            return mSkip;
+          }
+
+        private:
+          friend class Projection;
+
+          std::vector<Node> const *mNodes = nullptr;
+          Node const *mNode = nullptr; // nullptr keeps everything below
+          bool mSkip = false;
+
+          Filter(std::vector<Node> const *nodes, Node const *node, bool skip)
+            : mNodes{nodes}, mNode{node}, mSkip{skip} {
+          }
+
+          Filter _at(std::size_t index) const {
+            auto const *node = &(*mNodes)[index];
+            return Filter{mNodes, node->leaf ? nullptr : node, false};
+          }
+
+      };
+
+      Projection()
+        : mNodes(1) {
+      }
+
+      Projection(std::initializer_list<std::string_view> paths)
+        : Projection{} {
+        for (auto path : paths) {
+          add(path);
+        }
+      }
+
+      Projection & add(std::string_view path) {
+        std::vector<std::string> keys;
+
+        while (true) {
+          auto pos = path.find('.');
+          keys.emplace_back(path.substr(0, pos));
+          if (pos == std::string_view::npos) {
+            break;
+          }
+          path.remove_prefix(pos + 1);
+        }
+
+        return add(keys);
+      }
+
+      // path given as keys, for keys containing '.'
+      Projection & add(std::vector<std::string> const &keys) {
+        std::size_t index = 0;
+
+        for (auto const &key : keys) {
+          auto [i, inserted] = mNodes[index].children.try_emplace(key, mNodes.size());
+          index = i->second;
+          if (inserted) {
+            mNodes.emplace_back();
+          }
+        }
+
+        mNodes[index].leaf = true;
+
+        return *this;
+      }
+
+      // an empty path keeps the whole document
+      Filter filter() const {
+        return Filter{&mNodes, &mNodes.front(), false}._at(0);
+      }
+
+    private:
+      std::vector<Node> mNodes;
+
+  };
+
+}
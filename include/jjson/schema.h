@@ -0,0 +1,326 @@
+#pragma once
+
+#include "jjson/json.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace jjson {
+
+  // Compiled JSON Schema subset: type, enum, minimum, maximum,
+  // exclusiveMinimum, exclusiveMaximum, minLength, maxLength, required,
+  // properties, additionalProperties and items. Other keywords are ignored.
+  //
+  // The validator is a parse filter, so Json::parse(data, schema) checks the
+  // payload while scanning it and stops at the first violation.
+  class Schema {
+
+    struct Node {
+      uint8_t types = 0xff; // bit per JsonType
+      bool reject = false;
+      std::optional<double> minimum;
+      std::optional<double> maximum;
+      std::optional<double> exclusiveMinimum;
+      std::optional<double> exclusiveMaximum;
+      std::optional<std::size_t> minLength;
+      std::optional<std::size_t> maxLength;
+      std::vector<Json> enumeration;
+      std::vector<std::string> required;
+      std::unordered_map<std::string, std::size_t> properties;
+      std::optional<std::size_t> additionalProperties;
+      std::optional<std::size_t> items;
+    };
+
+    public:
+      class Validator {
+
+        public:
+          Validator() = default;
+
+          bool begin(JsonType type) const {
+            return mNode == nullptr || (!mNode->reject && (mNode->types & _bit(type)) != 0);
+          }
+
+          bool end(Json const &value) const {
+            if (mNode == nullptr) {
+              return true;
+            }
+
+            if (!begin(value.get_type())) {
+              return false;
+            }
+
+            if (!mNode->enumeration.empty() &&
+                std::find(mNode->enumeration.begin(), mNode->enumeration.end(), value) == mNode->enumeration.end()) {
+              return false;
+            }
+
+            if (value.is_integer() || value.is_decimal()) {
+              double number = _number(value);
+
+              return !(mNode->minimum && number < *mNode->minimum) &&
+                !(mNode->maximum && number > *mNode->maximum) &&
+                !(mNode->exclusiveMinimum && number <= *mNode->exclusiveMinimum) &&
+                !(mNode->exclusiveMaximum && number >= *mNode->exclusiveMaximum);
+            }
+
+            if (value.is_text() && (mNode->minLength || mNode->maxLength)) {
+              std::size_t length = _length(value.get_or_throw<std::string>());
+
+              return !(mNode->minLength && length < *mNode->minLength) &&
+                !(mNode->maxLength && length > *mNode->maxLength);
+            }
+
+            if (value.is_object()) {
+              for (auto const &key : mNode->required) {
+                if (!value.has(key)) {
+                  return false;
+                }
+              }
+            }
+
+            return true;
+          }
+
+          Validator member(std::string const &key) const {
+            if (mNode == nullptr) {
+              return {};
+            }
+
+            if (auto i = mNode->properties.find(key); i != mNode->properties.end()) {
+              return _at(i->second);
+            }
+
+            if (mNode->additionalProperties) {
+              return _at(*mNode->additionalProperties);
+            }
+
+            return {};
+          }
+
+          Validator element(std::size_t) const {
+            if (mNode == nullptr || !mNode->items) {
+              return {};
+            }
+
+            return _at(*mNode->items);
+          }
+
+        private:
+          friend class Schema;
+
+          std::vector<Node> const *mNodes = nullptr;
+          Node const *mNode = nullptr;
+
+          Validator(std::vector<Node> const *nodes, Node const *node)
+            : mNodes{nodes}, mNode{node} {
+          }
+
+          Validator _at(std::size_t index) const {
+            return Validator{mNodes, &(*mNodes)[index]};
+          }
+
+          static double _number(Json const &value) {
+            if (auto const *raw = std::get_if<RawNumber>(&value.get_value())) {
+              return raw->to_double();
+            }
+            return value.is_integer() ? static_cast<double>(value.get_or_throw<int64_t>()) : value.get_or_throw<double>();
+          }
+
+          static uint8_t _bit(JsonType type) {
+            return static_cast<uint8_t>(1u << static_cast<unsigned>(type));
+          }
+
+          // number of code points, as required by minLength/maxLength
+          static std::size_t _length(std::string const &text) {
+            return static_cast<std::size_t>(std::count_if(text.begin(), text.end(), [](char c) {
+              return (static_cast<unsigned char>(c) & 0xc0) != 0x80;
+            }));
+          }
+
+      };
+
+      static std::optional<Schema> compile(Json const &schema) {
+        Schema result;
+
+        result.mNodes = std::make_shared<std::vector<Node>>();
+
+        if (!result._compile(schema)) {
+          return {};
+        }
+
+        return result;
+      }
+
+      Validator validator() const {
+        return Validator{mNodes.get(), &mNodes->front()};
+      }
+
+      Validator filter() const {
+        return validator();
+      }
+
+      bool validate(Json const &value) const {
+        return _validate(validator(), value);
+      }
+
+    private:
+      std::shared_ptr<std::vector<Node>> mNodes;
+
+      Schema() = default;
+
+      std::optional<std::size_t> _compile(Json const &schema) {
+        std::size_t index = mNodes->size();
+
+        mNodes->emplace_back();
+
+        if (schema.is_bool()) {
+          (*mNodes)[index].reject = !schema.get_or_throw<bool>();
+          return index;
+        }
+
+        if (!schema.is_object()) {
+          return {};
+        }
+
+        Node node;
+
+        for (auto const &[keyword, value] : schema.get_or_throw<jObject>()) {
+          if (keyword == "type") {
+            node.types = 0;
+
+            if (value.is_text()) {
+              node.types = _types(value.get_or_throw<std::string>());
+            } else if (value.is_array()) {
+              for (auto const &item : value.get_or_throw<jArray>()) {
+                if (!item.is_text()) {
+                  return {};
+                }
+                node.types |= _types(item.get_or_throw<std::string>());
+              }
+            }
+
+            if (node.types == 0) {
+              return {};
+            }
+          } else if (keyword == "enum") {
+            if (!value.is_array()) {
+              return {};
+            }
+            node.enumeration = value.get_or_throw<jArray>();
+          } else if (keyword == "minimum" || keyword == "maximum" || keyword == "exclusiveMinimum" || keyword == "exclusiveMaximum") {
+            if (!value.is_integer() && !value.is_decimal()) {
+              return {};
+            }
+
+            double number = Validator::_number(value);
+
+            if (keyword == "minimum") {
+              node.minimum = number;
+            } else if (keyword == "maximum") {
+              node.maximum = number;
+            } else if (keyword == "exclusiveMinimum") {
+              node.exclusiveMinimum = number;
+            } else {
+              node.exclusiveMaximum = number;
+            }
+          } else if (keyword == "minLength" || keyword == "maxLength") {
+            auto length = value.get<int64_t>();
+
+            if (!length || *length < 0) {
+              return {};
+            }
+
+            (keyword == "minLength" ? node.minLength : node.maxLength) = static_cast<std::size_t>(*length);
+          } else if (keyword == "required") {
+            if (!value.is_array()) {
+              return {};
+            }
+
+            for (auto const &item : value.get_or_throw<jArray>()) {
+              if (!item.is_text()) {
+                return {};
+              }
+              node.required.push_back(item.get_or_throw<std::string>());
+            }
+          } else if (keyword == "properties") {
+            if (!value.is_object()) {
+              return {};
+            }
+
+            for (auto const &[name, property] : value.get_or_throw<jObject>()) {
+              auto child = _compile(property);
+
+              if (!child) {
+                return {};
+              }
+
+              node.properties.emplace(name, *child);
+            }
+          } else if (keyword == "additionalProperties") {
+            if (!(node.additionalProperties = _compile(value))) {
+              return {};
+            }
+          } else if (keyword == "items") {
+            if (!(node.items = _compile(value))) {
+              return {};
+            }
+          }
+        }
+
+        (*mNodes)[index] = std::move(node);
+
+        return index;
+      }
+
+      static uint8_t _types(std::string const &name) {
+        if (name == "null") {
+          return Validator::_bit(JsonType::Null);
+        } else if (name == "boolean") {
+          return Validator::_bit(JsonType::Bool);
+        } else if (name == "integer") {
+          return Validator::_bit(JsonType::Integer);
+        } else if (name == "number") {
+          return Validator::_bit(JsonType::Integer) | Validator::_bit(JsonType::Decimal);
+        } else if (name == "string") {
+          return Validator::_bit(JsonType::Text);
+        } else if (name == "array") {
+          return Validator::_bit(JsonType::Array);
+        } else if (name == "object") {
+          return Validator::_bit(JsonType::Object);
+        }
+        return 0;
+      }
+
+      static bool _validate(Validator const &validator, Json const &value) {
+        if (!validator.begin(value.get_type())) {
+          return false;
+        }
+
+        if (value.is_array()) {
+          auto const &array = value.get_or_throw<jArray>();
+
+          for (std::size_t i = 0; i < array.size(); i++) {
+            if (!_validate(validator.element(i), array[i])) {
+              return false;
+            }
+          }
+        } else if (value.is_object()) {
+          for (auto const &[key, member] : value.get_or_throw<jObject>()) {
+            if (!_validate(validator.member(key), member)) {
+              return false;
+            }
+          }
+        }
+
+        return validator.end(value);
+      }
+
+  };
+
+}
@@ -0,0 +1,363 @@
+#pragma once
+
+#include "jjson/json.h"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace jjson {
+
+  // Persistent Json tree: strings, arrays and objects are reference counted
+  // and shared between copies, so copying a SharedJson is O(1). Shared nodes
+  // are never modified; a write first copies every shared node on its path
+  // (copy-on-write), leaving the other versions untouched.
+  //
+  // A single SharedJson handle must not be written and read (or copied)
+  // concurrently, but different handles (snapshots) may be read, copied and
+  // destroyed on other threads while a writer builds new versions from its
+  // own handle, even when they share nodes with it.
+  class SharedJson {
+
+    public:
+      using array_type = std::vector<SharedJson>;
+      using object_type = std::unordered_map<std::string, SharedJson>;
+
+      SharedJson()
+        : mValue{nullptr} {
+      }
+
+      SharedJson(Json const &value) {
+        switch (value.get_type()) {
+          case JsonType::Null:
+            mValue = nullptr;
+            break;
+          case JsonType::Bool:
+            mValue = value.get_or_throw<bool>();
+            break;
+          case JsonType::Integer:
+          case JsonType::Decimal:
+            std::visit([&](auto number) {
+              mValue = number;
+            }, number_value(value));
+            break;
+          case JsonType::Text:
+            mValue = std::make_shared<std::string const>(value.get_or_throw<std::string>());
+            break;
+          case JsonType::Array: {
+            auto const &array = value.get_or_throw<jArray>();
+            auto result = std::make_shared<array_type>();
+            result->reserve(array.size());
+            for (auto const &i : array) {
+              result->emplace_back(i);
+            }
+            mValue = std::move(result);
+            break;
+          }
+          case JsonType::Object: {
+            auto const &object = value.get_or_throw<jObject>();
+            auto result = std::make_shared<object_type>();
+            result->reserve(object.size());
+            for (auto const &[k, v] : object) {
+              result->emplace(k, SharedJson{v});
+            }
+            mValue = std::move(result);
+            break;
+          }
+        }
+      }
+
+      template <JsonTypeConcept T>
+      SharedJson(T const &value)
+        : SharedJson{Json{value}} {
+      }
+
+      JsonType get_type() const {
+        return static_cast<JsonType>(mValue.index());
+      }
+
+      bool is_null() const {
+        return get_type() == JsonType::Null;
+      }
+
+      bool is_bool() const {
+        return get_type() == JsonType::Bool;
+      }
+
+      bool is_integer() const {
+        return get_type() == JsonType::Integer;
+      }
+
+      bool is_decimal() const {
+        return get_type() == JsonType::Decimal;
+      }
+
+      bool is_text() const {
+        return get_type() == JsonType::Text;
+      }
+
+      bool is_array() const {
+        return get_type() == JsonType::Array;
+      }
+
+      bool is_object() const {
+        return get_type() == JsonType::Object;
+      }
+
+      std::size_t size() const {
+        if (auto const *array = std::get_if<ArrayPtr>(&mValue)) {
+          return (*array)->size();
+        }
+        if (auto const *object = std::get_if<ObjectPtr>(&mValue)) {
+          return (*object)->size();
+        }
+        return 0;
+      }
+
+      SharedJson const & operator [] (std::size_t index) const {
+        if (auto const *array = std::get_if<ArrayPtr>(&mValue)) {
+          return (**array)[index];
+        }
+        throw std::runtime_error("invalid access");
+      }
+
+      SharedJson const & operator [] (std::string const &key) const {
+        if (auto const *object = std::get_if<ObjectPtr>(&mValue)) {
+          if (auto i = (*object)->find(key); i != (*object)->end()) {
+            return i->second;
+          }
+        }
+        throw std::runtime_error("invalid access");
+      }
+
+      bool has(std::string const &key) const {
+        auto const *object = std::get_if<ObjectPtr>(&mValue);
+        return object && (*object)->contains(key);
+      }
+
+      array_type const & array() const {
+        return *std::get<ArrayPtr>(mValue);
+      }
+
+      object_type const & object() const {
+        return *std::get<ObjectPtr>(mValue);
+      }
+
+      template <typename T>
+      std::optional<T> get() const {
+        if constexpr (std::same_as<T, int> || std::same_as<T, int64_t>) {
+          if (auto const *v = std::get_if<int64_t>(&mValue)) {
+            return static_cast<T>(*v);
+          }
+        } else if constexpr (std::same_as<T, float> || std::same_as<T, double>) {
+          if (auto const *v = std::get_if<double>(&mValue)) {
+            return static_cast<T>(*v);
+          }
+        } else if constexpr (std::same_as<T, bool>) {
+          if (auto const *v = std::get_if<bool>(&mValue)) {
+            return *v;
+          }
+        } else if constexpr (std::same_as<T, std::nullptr_t>) {
+          if (std::holds_alternative<std::nullptr_t>(mValue)) {
+            return nullptr;
+          }
+        } else if constexpr (std::same_as<T, std::string>) {
+          if (auto const *v = std::get_if<TextPtr>(&mValue)) {
+            return **v;
+          }
+        } else {
+          return json().get<T>();
+        }
+        return {};
+      }
+
+      // mutable access to a member/element, unsharing this node first
+      SharedJson & edit(std::string const &key) {
+        auto &object = _object();
+        if (auto i = object.find(key); i != object.end()) {
+          return i->second;
+        }
+        throw std::runtime_error("invalid access");
+      }
+
+      SharedJson & edit(std::size_t index) {
+        return _array().at(index);
+      }
+
+      SharedJson & set(std::string const &key, SharedJson value) {
+        if (!is_object()) {
+          mValue = std::make_shared<object_type>();
+        }
+        _object().insert_or_assign(key, std::move(value));
+        return *this;
+      }
+
+      SharedJson & set(std::size_t index, SharedJson value) {
+        _array().at(index) = std::move(value);
+        return *this;
+      }
+
+      SharedJson & push_back(SharedJson value) {
+        if (!is_array()) {
+          mValue = std::make_shared<array_type>();
+        }
+        _array().push_back(std::move(value));
+        return *this;
+      }
+
+      bool erase(std::string const &key) {
+        if (!has(key)) {
+          return false;
+        }
+        return _object().erase(key) > 0;
+      }
+
+      bool erase(std::size_t index) {
+        if (index >= size() || !is_array()) {
+          return false;
+        }
+        auto &array = _array();
+        array.erase(array.begin() + index);
+        return true;
+      }
+
+      // true if both handles refer to the same node (or equal scalars)
+      bool shares(SharedJson const &other) const {
+        if (mValue.index() != other.mValue.index()) {
+          return false;
+        }
+        if (auto const *ptr = std::get_if<TextPtr>(&mValue)) {
+          return *ptr == std::get<TextPtr>(other.mValue);
+        }
+        if (auto const *ptr = std::get_if<ArrayPtr>(&mValue)) {
+          return *ptr == std::get<ArrayPtr>(other.mValue);
+        }
+        if (auto const *ptr = std::get_if<ObjectPtr>(&mValue)) {
+          return *ptr == std::get<ObjectPtr>(other.mValue);
+        }
+        return *this == other;
+      }
+
+      Json json() const {
+        switch (get_type()) {
+          case JsonType::Null:
+            return Json{};
+          case JsonType::Bool:
+            return Json{std::get<bool>(mValue)};
+          case JsonType::Integer:
+            return Json{std::get<int64_t>(mValue)};
+          case JsonType::Decimal:
+            return Json{std::get<double>(mValue)};
+          case JsonType::Text:
+            return Json{*std::get<TextPtr>(mValue)};
+          case JsonType::Array: {
+            jArray result;
+            result.reserve(size());
+            for (auto const &i : array()) {
+              result.push_back(i.json());
+            }
+            return Json{std::move(result)};
+          }
+          case JsonType::Object: {
+            jObject result;
+            result.reserve(size());
+            for (auto const &[k, v] : object()) {
+              result.emplace(k, v.json());
+            }
+            return Json{std::move(result)};
+          }
+        }
+        return Json{};
+      }
+
+      std::string dump() const {
+        return json().dump();
+      }
+
+      friend bool operator == (SharedJson const &lhs, SharedJson const &rhs) {
+        if (lhs.mValue.index() != rhs.mValue.index()) {
+          return false;
+        }
+
+        switch (lhs.get_type()) {
+          case JsonType::Null: return true;
+          case JsonType::Bool: return std::get<bool>(lhs.mValue) == std::get<bool>(rhs.mValue);
+          case JsonType::Integer: return std::get<int64_t>(lhs.mValue) == std::get<int64_t>(rhs.mValue);
+          case JsonType::Decimal: return std::get<double>(lhs.mValue) == std::get<double>(rhs.mValue);
+          case JsonType::Text: {
+            auto const &a = std::get<TextPtr>(lhs.mValue);
+            auto const &b = std::get<TextPtr>(rhs.mValue);
+            return a == b || *a == *b;
+          }
+          case JsonType::Array: {
+            auto const &a = std::get<ArrayPtr>(lhs.mValue);
+            auto const &b = std::get<ArrayPtr>(rhs.mValue);
+            return a == b || *a == *b;
+          }
+          case JsonType::Object: {
+            auto const &a = std::get<ObjectPtr>(lhs.mValue);
+            auto const &b = std::get<ObjectPtr>(rhs.mValue);
+            return a == b || *a == *b;
+          }
+        }
+        return false;
+      }
+
+      friend std::ostream & operator << (std::ostream &out, SharedJson const &value) {
+        out << value.dump();
+        return out;
+      }
+
+    private:
+      using TextPtr = std::shared_ptr<std::string const>;
+      using ArrayPtr = std::shared_ptr<array_type>;
+      using ObjectPtr = std::shared_ptr<object_type>;
+
+      std::variant<std::nullptr_t, bool, int64_t, double, TextPtr, ArrayPtr, ObjectPtr> mValue;
+
+      // the node is copied (one level, children stay shared) if any other
+      // version still references it
+      array_type & _array() {
+        auto &array = std::get<ArrayPtr>(mValue);
+        if (!_unique(array)) {
+          array = std::make_shared<array_type>(*array);
+        }
+        return *array;
+      }
+
+      object_type & _object() {
+        auto &object = std::get<ObjectPtr>(mValue);
+        if (!_unique(object)) {
+          object = std::make_shared<object_type>(*object);
+        }
+        return *object;
+      }
+
+      // whether this version is the only owner of node, so it may be written
+      // in place. use_count() is a relaxed load: the acquire fence pairs with
+      // the release of the last other owner, so every read made through its
+      // snapshot happens before the write. A stale count above one only costs
+      // a copy, and the count can't rise from one behind our back since only
+      // this handle still reaches the node.
+      template <typename Ptr>
+      static bool _unique(Ptr const &node) {
+        if (node.use_count() > 1) {
+          return false;
+        }
+#if defined(__SANITIZE_THREAD__)
+        // ThreadSanitizer doesn't model fences, so its builds always copy
+        return false;
+#else
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+#endif
+      }
+
+  };
+
+}
@@ -0,0 +1,593 @@
+#pragma once
+
+#include "jjson/json.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jjson {
+
+  // String literal usable as a template argument
+  template <std::size_t N>
+  struct FixedString {
+    char data[N]{};
+
+    constexpr FixedString(char const (&text)[N]) {
+      std::copy_n(text, N, data);
+    }
+
+    constexpr std::string_view view() const {
+      return {data, N - 1};
+    }
+  };
+
+  namespace detail {
+
+    struct StaticNode {
+      JsonType type = JsonType::Null;
+      uint32_t size = 0; // text length or number of children
+      uint32_t offset = 0; // text offset or first child in the links
+      uint32_t keyOffset = 0;
+      uint32_t keySize = 0;
+      int64_t integer = 0; // integer or bool
+      double decimal = 0.0;
+    };
+
+    // Parser run in constant evaluation. Nodes are stored in document order
+    // and the children of each container are listed contiguously in links,
+    // object members sorted by key. Errors are thrown, and a throw can't be
+    // constant evaluated, so a malformed literal fails the build at the
+    // throw giving the reason.
+    class StaticParser {
+
+      public:
+        std::vector<StaticNode> nodes;
+        std::vector<uint32_t> links;
+        std::string text;
+
+        constexpr explicit StaticParser(std::string_view data)
+          : mState{data.data(), data.data() + data.size()} {
+          _skip_space();
+
+          if (mState.peek() == -1) {
+            throw std::invalid_argument("empty document");
+          }
+
+          _value();
+          _skip_space();
+
+          if (mState.peek() != -1) {
+            throw std::invalid_argument("unexpected data after the document");
+          }
+        }
+
+      private:
+        ParseState mState;
+
+        constexpr void _skip_space() {
+          // the characters std::isspace accepts in the C locale
+          while (mState.p < mState.end && (*mState.p == ' ' || (*mState.p >= '\t' && *mState.p <= '\r'))) {
+            ++mState.p;
+          }
+        }
+
+        constexpr void _literal(std::string_view word) {
+          for (char c : word) {
+            if (mState.get() != c) {
+              throw std::invalid_argument("invalid literal");
+            }
+          }
+        }
+
+        constexpr uint32_t _text(std::string_view value) {
+          auto offset = static_cast<uint32_t>(text.size());
+          text.append(value);
+          return offset;
+        }
+
+        constexpr void _string(uint32_t &offset, uint32_t &size) {
+          std::string value;
+
+          if (!mState.read_string(value)) {
+            throw std::invalid_argument("invalid string");
+          }
+
+          offset = _text(value);
+          size = static_cast<uint32_t>(value.size());
+        }
+
+        constexpr uint32_t _value() {
+          auto index = static_cast<uint32_t>(nodes.size());
+          StaticNode node;
+
+          nodes.emplace_back();
+
+          switch (mState.peek()) {
+            case 'n':
+              _literal("null");
+              break;
+            case 't':
+              _literal("true");
+              node.type = JsonType::Bool;
+              node.integer = 1;
+              break;
+            case 'f':
+              _literal("false");
+              node.type = JsonType::Bool;
+              break;
+            case '"':
+              node.type = JsonType::Text;
+              _string(node.offset, node.size);
+              break;
+            case '[':
+            case '{':
+              _container(node);
+              break;
+            default:
+              _number(node);
+              break;
+          }
+
+          int c = mState.peek();
+
+          if (c != -1 && c != ',' && c != ']' && c != '}' && c != ' ' && (c < '\t' || c > '\r')) {
+            throw std::invalid_argument("invalid value");
+          }
+
+          nodes[index] = node;
+
+          return index;
+        }
+
+        constexpr void _container(StaticNode &node) {
+          bool object = mState.get() == '{';
+          char close = object ? '}' : ']';
+          std::vector<uint32_t> children;
+
+          node.type = object ? JsonType::Object : JsonType::Array;
+
+          _skip_space();
+
+          if (mState.peek() == close) {
+            mState.get();
+          } else {
+            while (true) {
+              _skip_space();
+
+              uint32_t keyOffset = 0;
+              uint32_t keySize = 0;
+
+              if (object) {
+                if (mState.peek() != '"') {
+                  throw std::invalid_argument("expected a key");
+                }
+
+                _string(keyOffset, keySize);
+                _skip_space();
+
+                if (mState.get() != ':') {
+                  throw std::invalid_argument("expected ':'");
+                }
+
+                _skip_space();
+              }
+
+              uint32_t child = _value();
+
+              nodes[child].keyOffset = keyOffset;
+              nodes[child].keySize = keySize;
+              children.push_back(child);
+
+              _skip_space();
+
+              int c = mState.get();
+
+              if (c == close) {
+                break;
+              }
+
+              if (c != ',') {
+                throw std::invalid_argument("expected ',' or the end of the container");
+              }
+            }
+          }
+
+          if (object) {
+            auto key = [&](uint32_t i) {
+              return std::string_view{text}.substr(nodes[i].keyOffset, nodes[i].keySize);
+            };
+
+            std::sort(children.begin(), children.end(), [&](uint32_t a, uint32_t b) {
+              return key(a) < key(b);
+            });
+
+            for (std::size_t i = 1; i < children.size(); i++) {
+              if (key(children[i - 1]) == key(children[i])) {
+                throw std::invalid_argument("duplicate key");
+              }
+            }
+          }
+
+          node.size = static_cast<uint32_t>(children.size());
+          node.offset = static_cast<uint32_t>(links.size());
+          links.insert(links.end(), children.begin(), children.end());
+        }
+
+        // same syntax as Parser: decimal, 0x hexadecimal, 0b binary and
+        // 0-prefixed octal integers, and decimals with an optional exponent
+        // after the fraction
+        constexpr void _number(StaticNode &node) {
+          auto &ps = mState;
+          bool negative = false;
+          int base = 10;
+
+          if (ps.peek() == '-') {
+            negative = true;
+            ps.get();
+          }
+
+          auto lower = [](int c) {
+            return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+          };
+
+          auto digit = [&](int c) {
+            c = lower(c);
+            int value = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : 99;
+            return value < base ? value : -1;
+          };
+
+          if (ps.peek() == '0' && ps.p + 1 < ps.end) {
+            int c = lower(ps.p[1]);
+
+            if (c == 'x' || c == 'b') {
+              base = c == 'x' ? 16 : 2;
+              ps.p += 2;
+            } else if (c != '.') {
+              base = 8;
+            }
+          }
+
+          uint64_t mantissa = 0;
+          int exponent = 0;
+          bool digits = false;
+          bool overflow = false;
+
+          for (int d; (d = digit(ps.peek())) >= 0; ps.get()) {
+            digits = true;
+
+            if (mantissa > (std::numeric_limits<uint64_t>::max() - d)/base) {
+              overflow = true;
+              exponent++;
+            } else {
+              mantissa = mantissa*base + d;
+            }
+          }
+
+          if (base != 8 && base != 10) {
+            if (!digits) {
+              throw std::invalid_argument("invalid number");
+            }
+          } else if (base == 10 && ps.peek() == '.') {
+            ps.get();
+            node.type = JsonType::Decimal;
+
+            for (int d; (d = digit(ps.peek())) >= 0; ps.get()) {
+              digits = true;
+
+              if (mantissa <= (std::numeric_limits<uint64_t>::max() - d)/10) {
+                mantissa = mantissa*10 + d;
+                exponent--;
+              }
+            }
+
+            if (lower(ps.peek()) == 'e') {
+              int sign = 1;
+              int value = 0;
+
+              ps.get();
+
+              if (ps.peek() == '-' || ps.peek() == '+') {
+                sign = ps.get() == '-' ? -1 : 1;
+              }
+
+              for (int d; (d = digit(ps.peek())) >= 0; ps.get()) {
+                value = std::min(value*10 + d, 100000);
+              }
+
+              exponent += sign*value;
+            }
+          }
+
+          if (!digits) {
+            throw std::invalid_argument("invalid number");
+          }
+
+          if (node.type == JsonType::Decimal) {
+            node.decimal = _decimal(mantissa, exponent)*(negative ? -1 : 1);
+            return;
+          }
+
+          if (overflow || mantissa > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + negative) {
+            throw std::invalid_argument("integer out of range");
+          }
+
+          node.type = JsonType::Integer;
+          node.integer = negative ? static_cast<int64_t>(0 - mantissa) : static_cast<int64_t>(mantissa);
+        }
+
+        // mantissa*10^exponent, exact (correctly rounded) when the mantissa
+        // fits in 53 bits and |exponent| <= 22, which covers the literals
+        // written by hand; otherwise computed in long double
+        static constexpr double _decimal(uint64_t mantissa, int exponent) {
+          constexpr double powers[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+          };
+
+          if (mantissa < (uint64_t{1} << 53) && exponent >= -22 && exponent <= 22) {
+            auto value = static_cast<double>(mantissa);
+            return exponent < 0 ? value/powers[-exponent] : value*powers[exponent];
+          }
+
+          long double value = static_cast<long double>(mantissa);
+
+          for (; exponent > 0 && value != 0.0L; exponent--) {
+            value *= 10.0L;
+          }
+
+          for (; exponent < 0 && value != 0.0L; exponent++) {
+            value /= 10.0L;
+          }
+
+          return static_cast<double>(value);
+        }
+
+    };
+
+    struct StaticSizes {
+      std::size_t nodes;
+      std::size_t links;
+      std::size_t text;
+    };
+
+    template <FixedString Source>
+    consteval StaticSizes static_sizes() {
+      StaticParser parser{Source.view()};
+      return {parser.nodes.size(), parser.links.size(), parser.text.size()};
+    }
+
+  }
+
+  // Read-only view of a document parsed at compile time. Every member is
+  // constexpr except the conversions to Json, so lookups can also be
+  // checked with static_assert.
+  class StaticValue {
+
+    public:
+      constexpr StaticValue(detail::StaticNode const *nodes, uint32_t const *links, char const *text, uint32_t index)
+        : mNodes{nodes}, mLinks{links}, mText{text}, mIndex{index} {
+      }
+
+      constexpr JsonType get_type() const {
+        return _node().type;
+      }
+
+      constexpr bool is_null() const {
+        return get_type() == JsonType::Null;
+      }
+
+      constexpr bool is_bool() const {
+        return get_type() == JsonType::Bool;
+      }
+
+      constexpr bool is_integer() const {
+        return get_type() == JsonType::Integer;
+      }
+
+      constexpr bool is_decimal() const {
+        return get_type() == JsonType::Decimal;
+      }
+
+      constexpr bool is_text() const {
+        return get_type() == JsonType::Text;
+      }
+
+      constexpr bool is_array() const {
+        return get_type() == JsonType::Array;
+      }
+
+      constexpr bool is_object() const {
+        return get_type() == JsonType::Object;
+      }
+
+      // number of elements/members
+      constexpr std::size_t size() const {
+        return (is_array() || is_object()) ? _node().size : 0;
+      }
+
+      constexpr StaticValue operator [] (std::size_t index) const {
+        if (index >= size()) {
+          throw std::runtime_error("invalid access");
+        }
+        return _child(index);
+      }
+
+      constexpr StaticValue operator [] (std::string_view key) const {
+        if (auto value = find(key)) {
+          return *value;
+        }
+        throw std::runtime_error("invalid access");
+      }
+
+      // members are sorted by key
+      constexpr std::optional<StaticValue> find(std::string_view key) const {
+        if (!is_object()) {
+          return {};
+        }
+
+        std::size_t lo = 0;
+        std::size_t hi = size();
+
+        while (lo < hi) {
+          std::size_t mid = (lo + hi)/2;
+          auto candidate = _child(mid)._key();
+
+          if (candidate == key) {
+            return _child(mid);
+          }
+
+          if (candidate < key) {
+            lo = mid + 1;
+          } else {
+            hi = mid;
+          }
+        }
+
+        return {};
+      }
+
+      constexpr bool has(std::string_view key) const {
+        return find(key).has_value();
+      }
+
+      // key of the index-th member of an object
+      constexpr std::string_view key(std::size_t index) const {
+        if (!is_object() || index >= size()) {
+          throw std::runtime_error("invalid access");
+        }
+        return _child(index)._key();
+      }
+
+      template <typename T>
+      constexpr std::optional<T> get() const {
+        auto const &node = _node();
+
+        if constexpr (std::same_as<T, int> || std::same_as<T, int64_t>) {
+          if (node.type == JsonType::Integer) {
+            return static_cast<T>(node.integer);
+          }
+        } else if constexpr (std::same_as<T, float> || std::same_as<T, double>) {
+          if (node.type == JsonType::Decimal) {
+            return static_cast<T>(node.decimal);
+          }
+        } else if constexpr (std::same_as<T, bool>) {
+          if (node.type == JsonType::Bool) {
+            return node.integer != 0;
+          }
+        } else if constexpr (std::same_as<T, std::nullptr_t>) {
+          if (node.type == JsonType::Null) {
+            return nullptr;
+          }
+        } else if constexpr (std::same_as<T, std::string_view> || std::same_as<T, std::string>) {
+          if (node.type == JsonType::Text) {
+            return T{mText + node.offset, node.size};
+          }
+        } else {
+          return json().get<T>();
+        }
+        return {};
+      }
+
+      Json json() const {
+        switch (get_type()) {
+          case JsonType::Null:
+            return Json{};
+          case JsonType::Bool:
+            return Json{*get<bool>()};
+          case JsonType::Integer:
+            return Json{*get<int64_t>()};
+          case JsonType::Decimal:
+            return Json{*get<double>()};
+          case JsonType::Text:
+            return Json{*get<std::string>()};
+          case JsonType::Array: {
+            jArray result;
+            result.reserve(size());
+            for (std::size_t i = 0; i < size(); i++) {
+              result.push_back((*this)[i].json());
+            }
+            return Json{std::move(result)};
+          }
+          case JsonType::Object: {
+            jObject result;
+            result.reserve(size());
+            for (std::size_t i = 0; i < size(); i++) {
+              result.emplace(key(i), (*this)[i].json());
+            }
+            return Json{std::move(result)};
+          }
+        }
+        return Json{};
+      }
+
+      std::string dump() const {
+        return json().dump();
+      }
+
+    private:
+      detail::StaticNode const *mNodes;
+      uint32_t const *mLinks;
+      char const *mText;
+      uint32_t mIndex;
+
+      constexpr detail::StaticNode const & _node() const {
+        return mNodes[mIndex];
+      }
+
+      constexpr StaticValue _child(std::size_t index) const {
+        return StaticValue{mNodes, mLinks, mText, mLinks[_node().offset + index]};
+      }
+
+      constexpr std::string_view _key() const {
+        return {mText + _node().keyOffset, _node().keySize};
+      }
+
+  };
+
+  // Document parsed at compile time by parse_static(). Declared static
+  // constexpr it lives in read-only static storage, so nothing is parsed or
+  // allocated at startup.
+  template <std::size_t Nodes, std::size_t Links, std::size_t Chars>
+  struct StaticJson {
+    std::array<detail::StaticNode, Nodes> nodes;
+    std::array<uint32_t, Links> links;
+    std::array<char, Chars> text;
+
+    constexpr StaticValue root() const {
+      return StaticValue{nodes.data(), links.data(), text.data(), 0};
+    }
+
+    constexpr StaticValue operator [] (std::size_t index) const {
+      return root()[index];
+    }
+
+    constexpr StaticValue operator [] (std::string_view key) const {
+      return root()[key];
+    }
+  };
+
+  // static constexpr auto config = jjson::parse_static<R"({"port": 8080})">();
+  //
+  // A malformed literal is a compile error.
+  template <FixedString Source>
+  consteval auto parse_static() {
+    constexpr auto sizes = detail::static_sizes<Source>();
+
+    detail::StaticParser parser{Source.view()};
+    StaticJson<sizes.nodes, sizes.links, sizes.text> result{};
+
+    std::copy(parser.nodes.begin(), parser.nodes.end(), result.nodes.begin());
+    std::copy(parser.links.begin(), parser.links.end(), result.links.begin());
+    std::copy(parser.text.begin(), parser.text.end(), result.text.begin());
+
+    return result;
+  }
+
+}
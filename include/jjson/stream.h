@@ -0,0 +1,370 @@
+#pragma once
+
+#include "jjson/json.h"
+
+#include <cctype>
+#include <cerrno>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if __has_include(<generator>)
+#include <generator>
+#endif
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+namespace jjson {
+
+#if defined(__cpp_lib_generator)
+  template <typename T>
+  using Generator = std::generator<T>;
+#else
+  // Minimal stand-in for std::generator: a lazily evaluated input range whose
+  // elements are produced by co_yield. Exceptions thrown by the coroutine are
+  // rethrown when the range is advanced.
+  template <typename T>
+  class Generator {
+
+    public:
+      struct promise_type {
+        T *value = nullptr;
+        std::exception_ptr error;
+
+        Generator get_return_object() {
+          return Generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+          return {};
+        }
+
+        std::suspend_always final_suspend() noexcept {
+          return {};
+        }
+
+        // the yielded object lives in the coroutine frame until it is resumed
+        std::suspend_always yield_value(T &value) noexcept {
+          this->value = std::addressof(value);
+          return {};
+        }
+
+        std::suspend_always yield_value(T &&value) noexcept {
+          this->value = std::addressof(value);
+          return {};
+        }
+
+        void return_void() noexcept {
+        }
+
+        void unhandled_exception() {
+          error = std::current_exception();
+        }
+      };
+
+      class iterator {
+
+        public:
+          using value_type = T;
+          using difference_type = std::ptrdiff_t;
+
+          iterator() = default;
+
+          T & operator * () const {
+            return *mHandle.promise().value;
+          }
+
+          iterator & operator ++ () {
+            _resume(mHandle);
+            return *this;
+          }
+
+          void operator ++ (int) {
+            ++*this;
+          }
+
+          friend bool operator == (iterator const &it, std::default_sentinel_t) {
+            return it.mHandle.done();
+          }
+
+        private:
+          friend class Generator;
+
+          std::coroutine_handle<promise_type> mHandle;
+
+          explicit iterator(std::coroutine_handle<promise_type> handle)
+            : mHandle{handle} {
+          }
+      };
+
+      Generator(Generator &&other) noexcept
+        : mHandle{std::exchange(other.mHandle, {})} {
+      }
+
+      Generator & operator = (Generator &&other) noexcept {
+        std::swap(mHandle, other.mHandle);
+        return *this;
+      }
+
+      ~Generator() {
+        if (mHandle) {
+          mHandle.destroy();
+        }
+      }
+
+      iterator begin() {
+        _resume(mHandle);
+        return iterator{mHandle};
+      }
+
+      std::default_sentinel_t end() const noexcept {
+        return {};
+      }
+
+    private:
+      std::coroutine_handle<promise_type> mHandle;
+
+      explicit Generator(std::coroutine_handle<promise_type> handle)
+        : mHandle{handle} {
+      }
+
+      static void _resume(std::coroutine_handle<promise_type> handle) {
+        handle.resume();
+
+        if (auto error = std::exchange(handle.promise().error, {})) {
+          std::rethrow_exception(error);
+        }
+      }
+
+  };
+#endif
+
+  // Splits a stream of concatenated or whitespace separated JSON values and
+  // parses them one at a time. Input is read in chunks of a fixed size and
+  // the boundary scanner keeps its state between chunks, so each byte is
+  // scanned once and only the current document is held in memory.
+  class DocumentStream {
+
+    public:
+      // reads up to size bytes into data, returning 0 at the end of the input
+      using Reader = std::function<std::size_t(char *data, std::size_t size)>;
+
+      static constexpr std::size_t default_chunk_size = 64*1024;
+
+      DocumentStream(Reader reader, std::size_t chunkSize = default_chunk_size)
+        : mReader{std::move(reader)}, mChunkSize{chunkSize > 0 ? chunkSize : 1} {
+      }
+
+      explicit DocumentStream(std::istream &is, std::size_t chunkSize = default_chunk_size)
+        : DocumentStream{reader(is), chunkSize} {
+      }
+
+#if __has_include(<unistd.h>)
+      explicit DocumentStream(int fd, std::size_t chunkSize = default_chunk_size)
+        : DocumentStream{reader(fd), chunkSize} {
+      }
+#endif
+
+      static Reader reader(std::istream &is) {
+        return [&is](char *data, std::size_t size) {
+          is.read(data, static_cast<std::streamsize>(size));
+          return static_cast<std::size_t>(is.gcount());
+        };
+      }
+
+#if __has_include(<unistd.h>)
+      static Reader reader(int fd) {
+        return [fd](char *data, std::size_t size) {
+          ssize_t n;
+          do {
+            n = ::read(fd, data, size);
+          } while (n < 0 && errno == EINTR);
+          if (n < 0) {
+            throw std::runtime_error("unable to read the document stream");
+          }
+          return static_cast<std::size_t>(n);
+        };
+      }
+#endif
+
+      // parses the next document into out (reusing its storage). Returns
+      // false at the end of the input and throws if a document is malformed
+      // or truncated.
+      bool next(Json &out) {
+        std::size_t end;
+
+        while ((end = _scan()) == 0) {
+          if (!_fill()) {
+            if (mState == State::Idle) {
+              return false;
+            }
+
+            if (mState != State::Scalar) {
+              throw std::runtime_error("truncated document");
+            }
+
+            end = mBuffer.size();
+            break;
+          }
+        }
+
+        std::string_view document{mBuffer.data() + mBegin, end - mBegin};
+
+        mBegin = mScan = end;
+        mState = State::Idle;
+
+        if (!mParser.parse_into(document, out)) {
+          throw std::runtime_error("invalid document");
+        }
+
+        return true;
+      }
+
+    private:
+      enum class State {
+        Idle,
+        Scalar,
+        Container,
+        String
+      };
+
+      Reader mReader;
+      std::size_t mChunkSize;
+      std::string mBuffer;
+      std::size_t mBegin = 0; // first byte of the current document
+      std::size_t mScan = 0; // first byte not yet scanned
+      State mState = State::Idle;
+      bool mNested = false; // the string being scanned is inside a container
+      bool mEscape = false;
+      std::size_t mDepth = 0;
+      Parser mParser;
+
+      // returns the end of the current document, or 0 if more input is needed
+      std::size_t _scan() {
+        const char *data = mBuffer.data();
+        std::size_t size = mBuffer.size();
+
+        for (; mScan < size; mScan++) {
+          char c = data[mScan];
+
+          switch (mState) {
+            case State::Idle:
+              if (std::isspace(static_cast<unsigned char>(c))) {
+                mBegin = mScan + 1;
+              } else if (c == '"') {
+                mState = State::String;
+              } else if (c == '[' || c == '{') {
+                mState = State::Container;
+                mDepth = 1;
+              } else {
+                mState = State::Scalar;
+              }
+              break;
+            case State::Scalar:
+              // a scalar ends at the first byte that can't belong to a literal
+              if (std::isspace(static_cast<unsigned char>(c)) || c == '"' || c == '[' || c == '{') {
+                return mScan;
+              }
+              break;
+            case State::String:
+              if (mEscape) {
+                mEscape = false;
+              } else if (c == '\\') {
+                mEscape = true;
+              } else if (c == '"') {
+                if (!mNested) {
+                  return mScan + 1;
+                }
+                mState = State::Container;
+                mNested = false;
+              }
+              break;
+            case State::Container:
+              if (c == '"') {
+                mState = State::String;
+                mNested = true;
+              } else if (c == '[' || c == '{') {
+                mDepth++;
+              } else if ((c == ']' || c == '}') && --mDepth == 0) {
+                return mScan + 1;
+              }
+              break;
+          }
+        }
+
+        return 0;
+      }
+
+      // appends the next chunk, dropping the documents already consumed
+      bool _fill() {
+        if (mBegin > 0) {
+          mBuffer.erase(0, mBegin);
+          mScan -= mBegin;
+          mBegin = 0;
+        }
+
+        std::size_t size = mBuffer.size();
+
+        mBuffer.resize(size + mChunkSize);
+        mBuffer.resize(size + mReader(mBuffer.data() + size, mChunkSize));
+
+        return mBuffer.size() > size;
+      }
+
+  };
+
+  // Parses an input holding a single document (e.g. a decompressing reader)
+  // through the chunk buffer, so the whole input is never held at once.
+  // Returns nothing if the input is empty or has more than one document;
+  // malformed input throws like DocumentStream::next().
+  inline std::optional<Json> parse_stream(DocumentStream::Reader reader, std::size_t chunkSize = DocumentStream::default_chunk_size) {
+    DocumentStream stream{std::move(reader), chunkSize};
+    Json document;
+    Json extra;
+
+    if (!stream.next(document) || stream.next(extra)) {
+      return {};
+    }
+
+    return document;
+  }
+
+  // Yields every top-level value of the stream as soon as it is complete
+  inline Generator<Json> documents(DocumentStream::Reader reader, std::size_t chunkSize = DocumentStream::default_chunk_size) {
+    DocumentStream stream{std::move(reader), chunkSize};
+    Json document;
+
+    while (stream.next(document)) {
+      co_yield std::move(document);
+    }
+  }
+
+  inline Generator<Json> documents(std::istream &is, std::size_t chunkSize = DocumentStream::default_chunk_size) {
+    DocumentStream stream{is, chunkSize};
+    Json document;
+
+    while (stream.next(document)) {
+      co_yield std::move(document);
+    }
+  }
+
+#if __has_include(<unistd.h>)
+  inline Generator<Json> documents(int fd, std::size_t chunkSize = DocumentStream::default_chunk_size) {
+    DocumentStream stream{fd, chunkSize};
+    Json document;
+
+    while (stream.next(document)) {
+      co_yield std::move(document);
+    }
+  }
+#endif
+
+}
@@ -0,0 +1,87 @@
+#include "jjson/columnar.h"
+
+#include <gtest/gtest.h>
+
+using namespace jjson;
+
+TEST(ColumnarSuite, Infer) {
+  auto columns = parse_columns(R"([
+    {"id": 1, "name": "ana", "score": 7, "active": true},
+    {"id": 2, "name": null, "score": 8.5, "active": false, "extra": "x"},
+    {"score": 9, "id": 3, "name": "bia\n"},
+    {"id": 4, "name": "", "score": null, "active": true, "tags": null}
+  ])");
+
+  ASSERT_TRUE(columns);
+  ASSERT_EQ(columns->rows(), 4);
+  ASSERT_EQ(columns->columns().size(), 6);
+
+  auto const &id = (*columns)["id"];
+
+  ASSERT_EQ(id.type(), JsonType::Integer);
+  ASSERT_EQ(id.integers(), (std::vector<int64_t>{1, 2, 3, 4}));
+
+  auto const &name = (*columns)["name"];
+
+  ASSERT_EQ(name.type(), JsonType::Text);
+  ASSERT_EQ(name.text(0), "ana");
+  ASSERT_TRUE(name.is_null(1));
+  ASSERT_EQ(name.text(2), "bia\n");
+  ASSERT_FALSE(name.is_null(3));
+  ASSERT_EQ(name.text(3), "");
+  ASSERT_EQ(name.offsets(), (std::vector<uint64_t>{0, 3, 3, 7, 7}));
+
+  auto const &score = (*columns)["score"];
+
+  ASSERT_EQ(score.type(), JsonType::Decimal);
+  ASSERT_EQ(score.decimals(), (std::vector<double>{7.0, 8.5, 9.0, 0.0}));
+  ASSERT_TRUE(score.is_null(3));
+
+  auto const &active = (*columns)["active"];
+
+  ASSERT_EQ(active.type(), JsonType::Bool);
+  ASSERT_EQ(active.bools(), (std::vector<uint8_t>{1, 0, 0, 1}));
+  ASSERT_TRUE(active.is_null(2));
+
+  auto const &extra = (*columns)["extra"];
+
+  ASSERT_TRUE(extra.is_null(0));
+  ASSERT_EQ(extra.json(1), "x");
+  ASSERT_TRUE(extra.is_null(3));
+
+  ASSERT_EQ((*columns)["tags"].type(), JsonType::Null);
+  ASSERT_EQ(columns->find("missing"), nullptr);
+  ASSERT_THROW((*columns)["missing"], std::runtime_error);
+
+  ASSERT_EQ(parse_columns("[]")->rows(), 0);
+}
+
+TEST(ColumnarSuite, Schema) {
+  auto data = R"([
+    {"id": 1, "price": 2, "skip": {"nested": [1, 2, {"a": "]"}]}},
+    {"id": 2, "price": 2.5, "skip": "x"}
+  ])";
+
+  auto columns = parse_columns(data, {{"price", JsonType::Decimal}, {"id", JsonType::Integer}, {"absent", JsonType::Text}});
+
+  ASSERT_TRUE(columns);
+  ASSERT_EQ(columns->columns().size(), 3);
+  ASSERT_EQ(columns->columns()[0].name(), "price");
+  ASSERT_EQ((*columns)["price"].decimals(), (std::vector<double>{2.0, 2.5}));
+  ASSERT_EQ((*columns)["id"].integers(), (std::vector<int64_t>{1, 2}));
+  ASSERT_TRUE((*columns)["absent"].is_null(0));
+  ASSERT_TRUE((*columns)["absent"].is_null(1));
+
+  ASSERT_FALSE(parse_columns(data, {{"price", JsonType::Integer}}));
+  ASSERT_FALSE(parse_columns(data, {{"skip", JsonType::Object}}));
+}
+
+TEST(ColumnarSuite, Invalid) {
+  ASSERT_FALSE(parse_columns(R"({"a": 1})"));
+  ASSERT_FALSE(parse_columns(R"([1, 2])"));
+  ASSERT_FALSE(parse_columns(R"([{"a": [1]}])"));
+  ASSERT_FALSE(parse_columns(R"([{"a": 1}, {"a": "x"}])"));
+  ASSERT_FALSE(parse_columns(R"([{"a": 1, "a": 2}])"));
+  ASSERT_FALSE(parse_columns(R"([{"a": 1})"));
+  ASSERT_FALSE(parse_columns(R"([{"a": tru}])"));
+}
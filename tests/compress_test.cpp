@@ -0,0 +1,96 @@
+#include "jjson/compress.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+using namespace jjson;
+
+static Json parse(std::string_view data) {
+  return Json::parse(data).value();
+}
+
+static std::vector<Json> const expected{
+  parse(R"({"id": 1, "name": "first", "tags": ["a", "b"]})"),
+  parse(R"([1, 2.5, true, null, {"nested": {"text": "x\"y\n"}}])"),
+  Json{"text"},
+  Json{42}
+};
+
+template <typename Writer>
+static std::string compress(std::size_t bufferSize) {
+  std::ostringstream file;
+  Writer writer{file, 3, bufferSize};
+  std::ostream out{&writer};
+
+  for (auto const &document : expected) {
+    document.dump(out);
+    out << '\n';
+  }
+
+  EXPECT_TRUE(writer.finish());
+
+  return file.str();
+}
+
+template <typename Writer, typename Reader>
+static void round_trip(Reader reader) {
+  for (std::size_t bufferSize : {1, 7, 4096}) {
+    std::istringstream file{compress<Writer>(bufferSize)};
+    std::vector<Json> result;
+
+    for (auto &&document : documents(reader(DocumentStream::reader(file), bufferSize), bufferSize)) {
+      result.push_back(std::move(document));
+    }
+
+    ASSERT_EQ(result, expected) << bufferSize;
+  }
+
+  // concatenated members/frames are one stream
+  std::istringstream twice{compress<Writer>(64) + compress<Writer>(64)};
+  std::size_t count = 0;
+
+  for (auto &&document : documents(reader(DocumentStream::reader(twice), 16))) {
+    ASSERT_EQ(document, expected[count % expected.size()]);
+    count++;
+  }
+
+  ASSERT_EQ(count, 2*expected.size());
+
+  std::string data = compress<Writer>(4096);
+  std::istringstream truncated{data.substr(0, data.size() - 4)};
+
+  ASSERT_THROW(for (auto &&document : documents(reader(DocumentStream::reader(truncated), 4096))) { (void)document; }, std::runtime_error);
+
+  std::istringstream invalid{"this is not compressed"};
+
+  ASSERT_THROW(parse_stream(reader(DocumentStream::reader(invalid), 4096)), std::runtime_error);
+
+  // a single document through a fixed buffer
+  std::ostringstream file;
+  {
+    Writer writer{file, 3, 32};
+    std::ostream out{&writer};
+    expected[1].dump(out);
+  }
+
+  std::istringstream single{file.str()};
+
+  ASSERT_EQ(parse_stream(reader(DocumentStream::reader(single), 8), 8), expected[1]);
+}
+
+#if defined(JJSON_WITH_ZLIB)
+TEST(CompressSuite, Gzip) {
+  round_trip<GzipWriter>([](DocumentStream::Reader source, std::size_t bufferSize) {
+    return gzip_reader(std::move(source), bufferSize);
+  });
+}
+#endif
+
+#if defined(JJSON_WITH_ZSTD)
+TEST(CompressSuite, Zstd) {
+  round_trip<ZstdWriter>([](DocumentStream::Reader source, std::size_t bufferSize) {
+    return zstd_reader(std::move(source), bufferSize);
+  });
+}
+#endif
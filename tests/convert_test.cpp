@@ -0,0 +1,140 @@
+#include "jjson/convert.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+using namespace jjson;
+
+struct Point {
+  int x;
+  int y;
+};
+
+struct Legacy {
+  int64_t id;
+};
+
+static std::atomic<int> throws{0};
+
+namespace jjson {
+  bool json_to(Json const &value, Point &out) {
+    auto x = value.is_object() && value.has("x") ? value["x"].get<int>() : std::nullopt;
+    auto y = value.is_object() && value.has("y") ? value["y"].get<int>() : std::nullopt;
+
+    if (!x || !y) {
+      return false;
+    }
+
+    out = Point{*x, *y};
+    return true;
+  }
+
+  void json_to(Json const &value, Legacy &out) {
+    if (!value.is_integer()) {
+      throws++;
+      throw std::runtime_error("not an id");
+    }
+    out.id = value.get_or_throw<int64_t>();
+  }
+}
+
+static std::vector<Json> points(std::size_t size) {
+  std::vector<Json> result;
+
+  for (std::size_t i = 0; i < size; i++) {
+    if (i % 7 == 3) {
+      result.push_back(Json{{"x", static_cast<int64_t>(i)}});
+    } else {
+      result.push_back(Json{{"x", static_cast<int64_t>(i)}, {"y", static_cast<int64_t>(i*2)}});
+    }
+  }
+
+  return result;
+}
+
+TEST(ConvertSuite, Errors) {
+  auto values = points(1000);
+
+  for (std::size_t threads : {1, 2, 8}) {
+    auto result = convert_all<Point>(values, threads);
+
+    ASSERT_EQ(result.size(), values.size());
+
+    for (std::size_t i = 0; i < values.size(); i++) {
+      if (i % 7 == 3) {
+        ASSERT_FALSE(result[i]) << i;
+      } else {
+        ASSERT_TRUE(result[i]) << i;
+        ASSERT_EQ(result[i]->x, static_cast<int>(i));
+        ASSERT_EQ(result[i]->y, static_cast<int>(i*2));
+      }
+    }
+  }
+}
+
+TEST(ConvertSuite, Types) {
+  std::vector<Json> values{Json{1}, Json{"text"}, Json{2.5}, Json{jArray{1, 2}}, Json{}};
+
+  auto integers = convert_all<int64_t>(values, 4);
+  ASSERT_EQ(integers[0], 1);
+  ASSERT_FALSE(integers[1]);
+  ASSERT_FALSE(integers[2]);
+
+  auto texts = convert_all<std::string>(values, 4);
+  ASSERT_EQ(texts[1], "text");
+  ASSERT_FALSE(texts[0]);
+
+  // containers convert without throwing, dropping the elements that don't
+  auto vectors = convert_all<std::vector<int64_t>>(values, 4);
+  ASSERT_EQ(vectors[3], (std::vector<int64_t>{1, 2}));
+  ASSERT_FALSE(vectors[0]);
+  ASSERT_FALSE(vectors[4]);
+
+  auto nested = convert_all<std::vector<Point>>(std::vector<Json>{Json{jArray{Json{{"x", 1}, {"y", 2}}, Json{1}}}});
+  ASSERT_EQ(nested[0]->size(), 1u);
+
+  ASSERT_TRUE(convert_all<Point>(std::span<Json const>{}, 4).empty());
+}
+
+TEST(ConvertSuite, Exceptions) {
+  std::vector<Json> values;
+
+  for (int i = 0; i < 500; i++) {
+    values.push_back(i % 5 == 0 ? Json{"bad"} : Json{i});
+  }
+
+  throws = 0;
+
+  auto result = convert_all<Legacy>(values, 4);
+
+  ASSERT_EQ(throws, 100);
+
+  for (int i = 0; i < 500; i++) {
+    ASSERT_EQ(result[i].has_value(), i % 5 != 0);
+  }
+}
+
+TEST(ConvertSuite, Stealing) {
+  std::vector<std::atomic<int>> visits(10007);
+
+  // the first range holds all the slow items, so it has to be shared
+  detail::parallel_for(visits.size(), 4, 16, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++) {
+      if (i < visits.size()/4) {
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+      }
+      visits[i]++;
+    }
+  });
+
+  for (auto const &count : visits) {
+    ASSERT_EQ(count, 1);
+  }
+
+  ASSERT_THROW(detail::parallel_for(1000, 4, 8, [](std::size_t begin, std::size_t) {
+    if (begin >= 500) {
+      throw std::runtime_error("failed");
+    }
+  }), std::runtime_error);
+}
@@ -0,0 +1,80 @@
+#include "jjson/frozen.h"
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace jjson;
+
+static Json parse(std::string_view data) {
+  return Json::parse(data).value();
+}
+
+TEST(FrozenSuite, Lookup) {
+  auto doc = parse(R"({"a": [1, 2.5, "x", null, true], "b": {"c": {"d": "e"}}, "empty": {}, "list": []})");
+  auto frozen = freeze(doc);
+
+  ASSERT_EQ(frozen.root().json(), doc);
+  ASSERT_EQ(frozen["a"].size(), 5);
+  ASSERT_EQ(frozen["a"][0].get<int>(), 1);
+  ASSERT_EQ(frozen["a"][1].get<double>(), 2.5);
+  ASSERT_EQ(frozen["a"][2].get<std::string_view>(), "x");
+  ASSERT_TRUE(frozen["a"][3].is_null());
+  ASSERT_EQ(frozen["a"][4].get<bool>(), true);
+  ASSERT_EQ(frozen["b"]["c"]["d"].get<std::string>(), "e");
+  ASSERT_EQ(frozen["empty"].size(), 0);
+  ASSERT_FALSE(frozen["empty"].has("a"));
+  ASSERT_TRUE(frozen["list"].is_array());
+  ASSERT_FALSE(frozen.root().has("missing"));
+  ASSERT_FALSE(frozen["a"].has("a"));
+  ASSERT_THROW(frozen["missing"], std::runtime_error);
+  ASSERT_THROW(frozen["a"][5], std::runtime_error);
+}
+
+TEST(FrozenSuite, PerfectHash) {
+  jObject object;
+
+  for (int i = 0; i < 5000; i++) {
+    object.emplace("route/" + std::to_string(i), i);
+  }
+
+  auto frozen = freeze(Json{object});
+  auto root = frozen.root();
+
+  ASSERT_EQ(root.size(), object.size());
+
+  for (int i = 0; i < 5000; i++) {
+    ASSERT_EQ(root["route/" + std::to_string(i)].get<int>(), i);
+  }
+
+  for (std::size_t i = 0; i < root.size(); i++) {
+    ASSERT_EQ(root[root.key(i)].get<int>(), root[i].get<int>());
+  }
+
+  ASSERT_FALSE(root.has("route/5000"));
+  ASSERT_FALSE(root.has("route/"));
+}
+
+TEST(FrozenSuite, ConcurrentReaders) {
+  jObject object;
+
+  for (int i = 0; i < 1000; i++) {
+    object.emplace(std::to_string(i), jArray{i, std::to_string(i)});
+  }
+
+  auto frozen = freeze(Json{object});
+  std::vector<std::thread> readers;
+
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&frozen]() {
+      for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(frozen[std::to_string(i)][0].get<int>(), i);
+        EXPECT_EQ(frozen[std::to_string(i)][1].get<std::string>(), std::to_string(i));
+      }
+    });
+  }
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
@@ -0,0 +1,163 @@
+#include "jjson/incremental.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace jjson;
+
+static std::string_view text(std::string const &source, Span span) {
+  return std::string_view{source}.substr(span.begin, span.size());
+}
+
+static void expect_same(SourceMap::Node const &lhs, SourceMap::Node const &rhs) {
+  ASSERT_EQ(lhs.span(), rhs.span());
+  ASSERT_EQ(lhs.key(), rhs.key());
+  ASSERT_EQ(lhs.size(), rhs.size());
+
+  for (std::size_t i = 0; i < lhs.size(); i++) {
+    expect_same(lhs[i], rhs[i]);
+  }
+}
+
+// the document must match a full parse of its source
+static void expect_parsed(SourceDocument const &document) {
+  ASSERT_EQ(document.json(), Json::parse(document.source()).value());
+  expect_same(document.spans().root(), SourceMap::parse(document.source()).value().root());
+}
+
+TEST(IncrementalSuite, Spans) {
+  std::string data = R"( {"id": 12, "tags": ["a", true, -1.5e3], "user": {"name": "jeff"}, "none": null} )";
+  auto spans = SourceMap::parse(data).value();
+  auto root = spans.root();
+
+  ASSERT_EQ(text(data, root.span()), data.substr(1, data.size() - 2));
+  ASSERT_FALSE(root.key());
+  ASSERT_EQ(root.size(), 4u);
+
+  ASSERT_EQ(text(data, *root[0].key()), R"("id")");
+  ASSERT_EQ(text(data, root[0].span()), "12");
+  ASSERT_EQ(text(data, root[1].span()), R"(["a", true, -1.5e3])");
+  ASSERT_EQ(text(data, root[1][0].span()), R"("a")");
+  ASSERT_EQ(text(data, root[1][1].span()), "true");
+  ASSERT_EQ(text(data, root[1][2].span()), "-1.5e3");
+  ASSERT_FALSE(root[1][2].key());
+  ASSERT_EQ(text(data, *root[2][0].key()), R"("name")");
+  ASSERT_EQ(text(data, root[2][0].span()), R"("jeff")");
+  ASSERT_EQ(text(data, root[3].span()), "null");
+
+  ASSERT_THROW(root[4], std::runtime_error);
+
+  ASSERT_FALSE(SourceMap::parse(R"({"a": [1, 2})"));
+  ASSERT_FALSE(SourceMap::parse(R"(["a)"));
+  ASSERT_FALSE(SourceMap::parse(R"({"a" 1})"));
+  ASSERT_FALSE(SourceMap::parse(R"({"a": })"));
+}
+
+TEST(IncrementalSuite, Edit) {
+  auto document = SourceDocument::parse(R"({"id": 12, "tags": ["a", "b"], "user": {"name": "jeff"}})").value();
+  auto edit = [&](std::string_view from, std::string_view to) {
+    auto offset = document.source().find(from);
+    ASSERT_NE(offset, std::string::npos);
+    ASSERT_TRUE(document.edit(offset, from.size(), to));
+    expect_parsed(document);
+  };
+
+  edit("12", "1234");
+  ASSERT_EQ(document.json()["id"], Json{int64_t{1234}});
+
+  edit(R"("b")", R"("b", "c", 3)");
+  ASSERT_EQ(document.json()["tags"].get_or_throw<jArray>().size(), 4u);
+
+  edit(R"(, "c")", "");
+  ASSERT_EQ(document.json()["tags"], Json::parse(R"(["a", "b", 3])").value());
+
+  edit(R"("name")", R"("login")");
+  ASSERT_FALSE(document.json()["user"].has("name"));
+  ASSERT_EQ(document.json()["user"]["login"], Json{"jeff"});
+
+  edit(R"("jeff")", R"({"first": "jeff", "last": [1, 2]})");
+  edit("[1, 2]", "[]");
+  edit("[]", "[[[0]]]");
+  edit("0", "null, false");
+
+  edit(R"("id": 1234, )", "");
+  ASSERT_FALSE(document.json().has("id"));
+
+  // whole document
+  edit(document.source(), "[]");
+  edit("[]", " 42 ");
+  ASSERT_EQ(document.json(), Json{int64_t{42}});
+}
+
+TEST(IncrementalSuite, Reuse) {
+  auto document = SourceDocument::parse(R"({"a": {"text": "a long enough string to live on the heap" }, "b": [1, 2, 3]})").value();
+  auto const *before = document.json()["a"]["text"].get_or_throw<std::string>().data();
+
+  ASSERT_TRUE(document.edit(document.source().find('2'), 1, "20, 21"));
+  ASSERT_TRUE(document.edit(document.source().find("\"b\""), 3, "\"c\""));
+  ASSERT_TRUE(document.edit(document.source().find('}'), 0, ", \"x\": 1"));
+  expect_parsed(document);
+
+  ASSERT_EQ(document.json()["a"]["text"].get_or_throw<std::string>().data(), before);
+  ASSERT_EQ(document.json()["c"], Json::parse("[1, 20, 21, 3]").value());
+}
+
+TEST(IncrementalSuite, Invalid) {
+  std::string data = R"({"a": [1, 2], "b": "text"})";
+  auto document = SourceDocument::parse(data).value();
+  auto json = document.json();
+
+  ASSERT_FALSE(document.edit(data.size(), 1, ""));
+  ASSERT_FALSE(document.edit(data.find('2'), 1, "2x"));
+  ASSERT_FALSE(document.edit(data.find('2'), 1, "]"));
+  ASSERT_FALSE(document.edit(data.find("text"), 0, "\""));
+  ASSERT_EQ(document.error().kind, ParseErrorKind::InvalidKey);
+
+  ASSERT_EQ(document.source(), data);
+  ASSERT_EQ(document.json(), json);
+  expect_parsed(document);
+
+  // a repeated key takes the value of the last member
+  ASSERT_TRUE(document.edit(data.find("\"b\""), 3, "\"a\""));
+  expect_parsed(document);
+  ASSERT_EQ(document.json()["a"], Json{"text"});
+
+  ASSERT_TRUE(document.edit(document.source().find("[1, 2]"), 6, "[1, 2, 3]"));
+  expect_parsed(document);
+
+  ASSERT_FALSE(SourceDocument::parse("[1, 2"));
+}
+
+TEST(IncrementalSuite, RandomEdits) {
+  std::mt19937 random{42};
+  std::vector<std::string> pieces{"", " ", ",", ":", "0", "12", "-3.5", "\"", "\"k\"", "\"k\": 1", "[", "]", "{", "}",
+    "true", "null", "[1, 2]", "{\"x\": []}", "\\"};
+  std::string data = R"({"a": [1, [2, 3], {"b": "c", "d": [true, false]}], "e": {"f": {"g": null}}, "h": "i"})";
+  auto document = SourceDocument::parse(data).value();
+
+  for (int i = 0; i < 5000; i++) {
+    auto const &source = document.source();
+    std::size_t offset = random() % (source.size() + 1);
+    std::size_t length = std::min<std::size_t>(random() % 4, source.size() - offset);
+    auto const &piece = pieces[random() % pieces.size()];
+    std::string edited = std::string{source}.replace(offset, length, piece);
+    auto expected = Json::parse(edited);
+    std::string previous = source;
+
+    ASSERT_EQ(document.edit(offset, length, piece), expected.has_value()) << edited;
+
+    if (expected) {
+      ASSERT_EQ(document.source(), edited);
+    } else {
+      ASSERT_EQ(document.source(), previous);
+    }
+
+    expect_parsed(document);
+
+    // keep the document from shrinking to a scalar for good
+    if (document.source().size() < 8) {
+      ASSERT_TRUE(document.edit(0, document.source().size(), data));
+    }
+  }
+}
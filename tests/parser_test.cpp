@@ -1,6 +1,9 @@
 #include <chrono>
 #include <fcntl.h>
+#include <cstdlib>
 #include <fstream>
+#include <map>
+#include <memory_resource>
 
 #include "jjson/json.h"
 
@@ -8,6 +11,56 @@
 
 using namespace jjson;
 
+// allocations made on this thread while an AllocationCount is alive, so the
+// replaced operators don't count for the other tests
+static std::size_t allocations = 0;
+static thread_local bool counting = false;
+
+struct AllocationCount {
+  AllocationCount() {
+    allocations = 0;
+    counting = true;
+  }
+
+  ~AllocationCount() {
+    counting = false;
+  }
+};
+
+static void * allocate(std::size_t size) {
+  if (counting) {
+    allocations++;
+  }
+  if (void *ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void * operator new (std::size_t size) {
+  return allocate(size);
+}
+
+void * operator new[] (std::size_t size) {
+  return allocate(size);
+}
+
+void operator delete (void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete (void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[] (void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[] (void *ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
 struct MyRect {
   int x;
   int y;
@@ -380,3 +433,412 @@ TEST(JsonSuite, BigData) {
 
   std::cout << "Size: " << value.value().get<jArray>().value().size() << std::endl;
 }
+
+TEST(JsonSuite, Strings) {
+  ASSERT_EQ(Json::parse(R"("a\"b\\c\/d")"), "a\"b\\c/d");
+  ASSERT_EQ(Json::parse(R"("\b\f\n\r\t")"), "\b\f\n\r\t");
+  ASSERT_EQ(Json::parse(R"("Aé€")"), "Aé€");
+  ASSERT_EQ(Json::parse(R"("😀")"), "\U0001F600");
+  ASSERT_EQ(Json::parse("\"ação 日本 😀\""), "ação 日本 😀");
+  ASSERT_EQ(Json::parse(R"("a long run of plain ascii text that crosses several sixteen byte blocks")"),
+      "a long run of plain ascii text that crosses several sixteen byte blocks");
+  ASSERT_EQ(Json::parse(R"({"kéy": "v"})").value()["kéy"], "v");
+
+  ASSERT_FALSE(Json::parse(R"("\x")"));
+  ASSERT_FALSE(Json::parse(R"("\u00")"));
+  ASSERT_FALSE(Json::parse(R"("\u00zz")"));
+  ASSERT_FALSE(Json::parse(R"("\ud83d")"));
+  ASSERT_FALSE(Json::parse(R"("\ud83dA")"));
+  ASSERT_FALSE(Json::parse(R"("\ude00")"));
+  ASSERT_FALSE(Json::parse("\"\xff\""));
+  ASSERT_FALSE(Json::parse("\"\xc0\xaf\""));
+  ASSERT_FALSE(Json::parse("\"\xed\xa0\x80\""));
+  ASSERT_FALSE(Json::parse("\"\xf4\x90\x80\x80\""));
+  ASSERT_FALSE(Json::parse("\"\xe6\x97\""));
+
+  Json text{"quote \" slash \\ newline \n tab \t bell \x07 é"};
+
+  ASSERT_EQ(text.dump(), R"("quote \" slash \\ newline \n tab \t bell \u0007 é")");
+  ASSERT_EQ(Json::parse(text.dump()), text);
+}
+
+TEST(JsonSuite, ParserReuse) {
+  Parser parser;
+  Json doc;
+
+  ASSERT_TRUE(parser.parse_into(R"({"a": 1, "b": [1, 2, 3], "c": {"d": "text"}})", doc));
+  ASSERT_EQ(doc, Json::parse(R"({"a": 1, "b": [1, 2, 3], "c": {"d": "text"}})"));
+
+  ASSERT_TRUE(parser.parse_into(R"({"a": "x", "b": [4], "e": null})", doc));
+  ASSERT_EQ(doc, Json::parse(R"({"a": "x", "b": [4], "e": null})"));
+
+  ASSERT_TRUE(parser.parse_into(R"({"b": [1, 2, 3, 4, 5], "c": {"d": "y", "f": true}, "g": 1.5})", doc));
+  ASSERT_EQ(doc, Json::parse(R"({"b": [1, 2, 3, 4, 5], "c": {"d": "y", "f": true}, "g": 1.5})"));
+
+  ASSERT_TRUE(parser.parse_into(R"({"a": 1, "a": 2})", doc));
+  ASSERT_EQ(doc, Json::parse(R"({"a": 2})"));
+
+  ASSERT_TRUE(parser.parse_into("[1, [2, 3], 4]", doc));
+  ASSERT_EQ(doc, Json::parse("[1, [2, 3], 4]"));
+
+  ASSERT_FALSE(parser.parse_into("[1, 2", doc));
+  ASSERT_EQ(parser.parse("[true]"), Json::parse("[true]"));
+}
+
+TEST(JsonSuite, ParserSteadyState) {
+  Parser parser;
+  Json doc;
+  std::vector<std::string> messages;
+
+  for (int i = 0; i < 100; i++) {
+    messages.push_back(R"({"id": )" + std::to_string(i) + R"(, "type": "event", "ok": true, "score": )" +
+        std::to_string(i) + R"(.5, "tags": ["a", "b"], "user": {"name": "user )" + std::to_string(i % 7) + R"("}})");
+  }
+
+  // warm up the document and the parser buffers
+  ASSERT_TRUE(parser.parse_into(messages[0], doc));
+  ASSERT_TRUE(parser.parse_into(messages[0], doc));
+
+  {
+    AllocationCount count;
+
+    for (auto const &message : messages) {
+      ASSERT_TRUE(parser.parse_into(message, doc));
+    }
+  }
+
+  ASSERT_EQ(allocations, 0);
+  ASSERT_EQ(doc["user"]["name"], "user 1");
+}
+
+TEST(JsonSuite, RawNumbers) {
+  auto data = R"({"big": 123456789012345678901234567890, "price": 19.990000000000000001, "id": -42, "hex": 0xff, "mode": 0755, "ratio": 0.25, "exp": -1.5e3, "text": "1"})";
+  auto doc = Parser{NumberMode::Raw}.parse(data).value();
+
+  ASSERT_TRUE(doc["big"].is_integer());
+  ASSERT_TRUE(doc["price"].is_decimal());
+  ASSERT_EQ(doc["id"].get<int64_t>(), -42);
+  ASSERT_EQ(doc["id"].get<int>(), -42);
+  ASSERT_EQ(doc["id"], int64_t{-42});
+  ASSERT_EQ(doc["hex"].get<int>(), 255);
+  ASSERT_EQ(doc["mode"].get<int>(), 0755);
+  ASSERT_EQ(doc["ratio"].get<double>(), 0.25);
+  ASSERT_EQ(doc["exp"].get<double>(), -1500.0);
+  ASSERT_FALSE(doc["ratio"].get<int64_t>());
+  ASSERT_FALSE(doc["id"].get<double>());
+
+  // exact access instead of a wrapped or rounded value
+  ASSERT_FALSE(doc["big"].get<int64_t>());
+  ASSERT_EQ(doc["big"].get_or_throw<RawNumber>().text(), "123456789012345678901234567890");
+  ASSERT_EQ(doc["big"].get_or_throw<RawNumber>().exact(), (RawNumber::Decimal{false, "12345678901234567890123456789", 1}));
+  ASSERT_EQ(doc["price"].get_or_throw<RawNumber>().exact(), (RawNumber::Decimal{false, "19990000000000000001", -18}));
+  ASSERT_EQ(doc["hex"].get_or_throw<RawNumber>().exact(), (RawNumber::Decimal{false, "255", 0}));
+  ASSERT_EQ(doc["exp"].get_or_throw<RawNumber>().exact(), (RawNumber::Decimal{true, "15", 2}));
+  ASSERT_EQ(RawNumber::parse("-0.000")->exact(), RawNumber::Decimal{});
+  ASSERT_EQ(RawNumber::parse("255")->get<uint8_t>(), 255);
+  ASSERT_FALSE(RawNumber::parse("256")->get<uint8_t>());
+  ASSERT_FALSE(RawNumber::parse("-1")->get<uint64_t>());
+  ASSERT_EQ(RawNumber::parse("-9223372036854775808")->get<int64_t>(), INT64_MIN);
+  ASSERT_FALSE(RawNumber::parse("1 2"));
+  ASSERT_FALSE(RawNumber::parse("x"));
+
+  // the text is written back unchanged
+  auto dumped = Parser{NumberMode::Raw}.parse(R"([123456789012345678901234567890,19.990000000000000001,1.50])").value().dump();
+
+  ASSERT_EQ(dumped, "[123456789012345678901234567890,19.990000000000000001,1.50]");
+
+  // raw numbers compare by value with converted ones
+  ASSERT_EQ(Parser{NumberMode::Raw}.parse("[1, 2.5, 1.50]"), Json::parse("[1, 2.5, 1.5]"));
+  ASSERT_EQ(Parser{NumberMode::Raw}.parse("1.50"), Parser{NumberMode::Raw}.parse("1.5"));
+  ASSERT_NE(Parser{NumberMode::Raw}.parse("1"), Json::parse("1.0"));
+  ASSERT_EQ(doc["text"], "1");
+
+  // conversion for stores without raw text
+  ASSERT_EQ(number_value(doc["id"]), (std::variant<int64_t, double>{int64_t{-42}}));
+  ASSERT_EQ(number_value(doc["price"]), (std::variant<int64_t, double>{19.99}));
+  ASSERT_EQ(number_value(Json{2.5}), (std::variant<int64_t, double>{2.5}));
+  ASSERT_THROW(number_value(doc["big"]), std::range_error);
+
+  // the int and float converters read raw numbers as well
+  int integer = 0;
+  float decimal = 0;
+
+  json_to(doc["id"], integer);
+  json_to(doc["ratio"], decimal);
+  ASSERT_EQ(integer, -42);
+  ASSERT_EQ(decimal, 0.25f);
+  ASSERT_THROW(json_to(doc["big"], integer), std::runtime_error);
+  ASSERT_THROW(json_to(doc["text"], decimal), std::runtime_error);
+}
+
+TEST(JsonSuite, ParseErrors) {
+  auto error = [](std::string_view data) {
+    auto result = Json::try_parse(data);
+    EXPECT_FALSE(result.has_value()) << data;
+    return result.has_value() ? ParseError{} : result.error();
+  };
+
+  ASSERT_EQ(Json::try_parse(R"({"a": [1, 2.5, "x", null]})").value(), Json::parse(R"({"a": [1, 2.5, "x", null]})"));
+
+  ASSERT_EQ(error("[1, 2"), (ParseError{ParseErrorKind::UnexpectedEnd, 5, 1, 6}));
+  ASSERT_EQ(error("{\n  \"a\": tru\n}"), (ParseError{ParseErrorKind::InvalidLiteral, 9, 2, 8}));
+  ASSERT_EQ(error("[1,\n 2,\n #]"), (ParseError{ParseErrorKind::UnexpectedCharacter, 9, 3, 2}));
+  ASSERT_EQ(error("[1.2.3]"), (ParseError{ParseErrorKind::InvalidNumber, 1, 1, 2}));
+  ASSERT_EQ(error(R"(["a\qb"])"), (ParseError{ParseErrorKind::InvalidString, 5, 1, 6}));
+  ASSERT_EQ(error(R"({"a": 1, 2})"), (ParseError{ParseErrorKind::InvalidKey, 9, 1, 10}));
+  ASSERT_EQ(error(R"({"": 1})"), (ParseError{ParseErrorKind::InvalidKey, 1, 1, 2}));
+  ASSERT_EQ(error(R"({"a" 1})"), (ParseError{ParseErrorKind::ExpectedColon, 5, 1, 6}));
+  ASSERT_EQ(error(R"(["abc)").kind, ParseErrorKind::UnexpectedEnd);
+
+  struct NoText : ParseFilter {
+    bool begin(JsonType type) const {
+      return type != JsonType::Text;
+    }
+
+    NoText member(std::string const &) const {
+      return {};
+    }
+
+    NoText element(std::size_t) const {
+      return {};
+    }
+  };
+
+  auto rejected = Json::try_parse(R"({"a": [1, "x"]})", NoText{});
+
+  ASSERT_EQ(rejected.error(), (ParseError{ParseErrorKind::Rejected, 10, 1, 11}));
+
+  Parser parser;
+  Json doc;
+
+  ASSERT_FALSE(parser.parse_into("[1, }", doc));
+  ASSERT_EQ(parser.error().kind, ParseErrorKind::UnexpectedCharacter);
+  ASSERT_EQ(parser.error().offset, 4);
+}
+
+TEST(JsonSuite, DumpParallel) {
+  jArray rows;
+
+  for (int i = 0; i < 2000; i++) {
+    rows.push_back(Json{jObject{
+      {"id", Json{int64_t{i}}},
+      {"name", Json{"row \"" + std::to_string(i) + "\"\n"}},
+      {"score", Json{i*0.5}},
+      {"tags", Json{jArray{Json{true}, Json{}, Json{jObject{}}, Json{jArray{}}}}}}});
+  }
+
+  Json array{rows};
+  Json nested{jObject{{"count", Json{int64_t{2000}}}, {"rows", array}, {"more", Json{jObject{{"rows", array}, {"empty", Json{jArray{}}}}}}}};
+  Json raw = Parser{NumberMode::Raw}.parse(array.dump()).value();
+
+  for (std::size_t threads : {1, 2, 3, 8}) {
+    ASSERT_EQ(array.dump_parallel(threads), array.dump());
+    ASSERT_EQ(nested.dump_parallel(threads), nested.dump());
+    ASSERT_EQ(raw.dump_parallel(threads), raw.dump());
+  }
+
+  // deep nesting, with light containers next to the heavy ones on every level
+  Json deep{array};
+
+  for (int i = 0; i < 500; i++) {
+    jArray level;
+
+    level.push_back(Json{jObject{{"x", Json{jArray{Json{int64_t{i}}}}}}});
+    level.push_back(std::move(deep));
+    level.push_back(rows[i]);
+    deep = Json{std::move(level)};
+  }
+
+  for (std::size_t threads : {2, 8}) {
+    ASSERT_EQ(deep.dump_parallel(threads), deep.dump());
+  }
+
+  ASSERT_EQ(Json::parse(nested.dump_parallel(4)), nested);
+  ASSERT_EQ(Json{"x"}.dump_parallel(4), "\"x\"");
+  ASSERT_EQ(Json{jArray{}}.dump_parallel(4), "[]");
+}
+
+TEST(JsonSuite, DumpStream) {
+  auto doc = Json::parse(R"({"a": [1, 2.5, 3.0, true, null, "x\ty"]})").value();
+  std::ostringstream out;
+
+  out << std::hex << std::fixed << std::setprecision(2) << 255 << " ";
+  doc.dump(out);
+  out << " " << 255;
+
+  ASSERT_EQ(out.str(), "ff " + doc.dump() + " ff");
+}
+
+TEST(JsonSuite, MemoryUsage) {
+  std::string text(100, 'x');
+  auto doc = Json::parse(R"({"items": [1, 2, 3], "text": ")" + text + R"(", "short": "abc", "empty": {}})").value();
+  auto usage = doc.memory_usage();
+
+  ASSERT_EQ(Json{}.memory_usage(), MemoryUsage{});
+  ASSERT_EQ(Json{"abc"}.memory_usage(), MemoryUsage{});
+  ASSERT_EQ(usage.arrays, doc["items"].get_or_throw<jArray>().capacity()*sizeof(Json));
+  ASSERT_GE(usage.strings, text.size() + 1);
+  ASSERT_EQ(usage.nodes, 7*sizeof(Json));
+  ASSERT_GT(usage.objects, 4*sizeof(Json));
+  ASSERT_GT(usage.buckets, 0);
+  ASSERT_GE(usage.slack, usage.arrays - 3*sizeof(Json));
+  ASSERT_EQ(usage.total(), usage.strings + usage.arrays + usage.objects + usage.buckets);
+
+  auto copy = doc;
+
+  doc.shrink_to_fit();
+
+  auto trimmed = doc.memory_usage();
+
+  ASSERT_EQ(doc, copy);
+  ASSERT_EQ(trimmed.arrays, 3*sizeof(Json));
+  ASSERT_EQ(trimmed.slack, 0);
+  ASSERT_LT(trimmed.total(), usage.total());
+
+  // reused keys and raw numbers keep the capacity of longer predecessors
+  Parser parser{NumberMode::Raw};
+  Json reused;
+
+  ASSERT_TRUE(parser.parse_into(R"({"a": {"a rather long key to fill the buffer": 12345678901234567890123}})", reused));
+  ASSERT_TRUE(parser.parse_into(R"({"b": {"a short key but still not small": 1}})", reused));
+  reused.shrink_to_fit();
+  ASSERT_EQ(reused.memory_usage().slack, 0);
+  ASSERT_EQ(reused, Json::parse(R"({"b": {"a short key but still not small": 1}})"));
+}
+
+// insertion ordered map without node handles or buckets
+template <typename Key, typename Value>
+class FlatMap : public std::vector<std::pair<Key, Value>> {
+
+  public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using std::vector<std::pair<Key, Value>>::vector;
+
+    auto find(Key const &key) {
+      return std::find_if(this->begin(), this->end(), [&](auto const &member) {
+        return member.first == key;
+      });
+    }
+
+    auto find(Key const &key) const {
+      return std::find_if(this->begin(), this->end(), [&](auto const &member) {
+        return member.first == key;
+      });
+    }
+
+    bool contains(Key const &key) const {
+      return find(key) != this->end();
+    }
+
+    auto try_emplace(Key const &key) {
+      if (auto i = find(key); i != this->end()) {
+        return std::pair{i, false};
+      }
+      this->emplace_back(key, Value{});
+      return std::pair{std::prev(this->end()), true};
+    }
+
+    friend bool operator == (FlatMap const &lhs, FlatMap const &rhs) {
+      return lhs.size() == rhs.size() && std::all_of(lhs.begin(), lhs.end(), [&](auto const &member) {
+        auto i = rhs.find(member.first);
+        return i != rhs.end() && i->second == member.second;
+      });
+    }
+
+};
+
+struct CompactTraits {
+  using integer_type = int32_t;
+  using decimal_type = float;
+  using text_type = std::string;
+
+  template <typename Value>
+  using array_type = std::vector<Value>;
+
+  template <typename Value>
+  using object_type = FlatMap<std::string, Value>;
+};
+
+struct ArenaTraits {
+  using integer_type = int64_t;
+  using decimal_type = double;
+  using text_type = std::pmr::string;
+
+  template <typename Value>
+  using array_type = std::pmr::vector<Value>;
+
+  template <typename Value>
+  using object_type = std::pmr::map<std::pmr::string, Value>;
+};
+
+class CountingResource : public std::pmr::memory_resource {
+
+  public:
+    std::size_t allocated = 0;
+
+  private:
+    void * do_allocate(std::size_t bytes, std::size_t alignment) override {
+      allocated += bytes;
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override {
+      return this == &other;
+    }
+
+};
+
+TEST(JsonSuite, Traits) {
+  using Compact = BasicJson<CompactTraits>;
+
+  static_assert(std::same_as<Compact::integer_type, int32_t>);
+  static_assert(std::same_as<Json, BasicJson<JsonTraits>>);
+
+  auto doc = Compact::parse(R"({"id": 7, "ratio": 0.5, "tags": ["a", "b"], "nested": {"x": null}})").value();
+
+  ASSERT_EQ(doc["id"], int32_t{7});
+  ASSERT_EQ(doc["ratio"].get<float>(), 0.5f);
+  ASSERT_EQ(doc["tags"][1], "b");
+  ASSERT_EQ(doc.dump(), R"({"id":7,"ratio":0.5,"tags":["a","b"],"nested":{"x":null}})");
+  ASSERT_EQ(doc.dump_parallel(4), doc.dump());
+  ASSERT_EQ(doc, Compact::parse(R"({"nested": {"x": null}, "tags": ["a", "b"], "ratio": 0.5, "id": 7})"));
+  ASSERT_EQ(Compact::try_parse("[2147483648]").error().kind, ParseErrorKind::InvalidNumber);
+  ASSERT_EQ(doc.memory_usage().buckets, 0);
+
+  // objects without node handles are rebuilt by a reused parser
+  BasicParser<CompactTraits> parser;
+  Compact out;
+
+  ASSERT_TRUE(parser.parse_into(R"({"a": 1, "b": {"c": 2}})", out));
+  ASSERT_TRUE(parser.parse_into(R"({"b": {"d": 3}})", out));
+  ASSERT_EQ(out.dump(), R"({"b":{"d":3}})");
+
+  // every allocation of the tree goes through the default memory resource
+  using Arena = BasicJson<ArenaTraits>;
+
+  // moving between memory resources copies, so it may throw
+  static_assert(std::is_nothrow_move_assignable_v<Json>);
+  static_assert(!std::is_nothrow_move_assignable_v<Arena>);
+
+  CountingResource counting;
+  auto *previous = std::pmr::set_default_resource(&counting);
+  auto value = Arena::parse(R"({"list": [1, 2.5, "a text too long for the inline buffer"], "flag": true})").value();
+
+  std::pmr::set_default_resource(previous);
+
+  ASSERT_GT(counting.allocated, value.memory_usage().total() - 1);
+  ASSERT_EQ(value.dump(), R"({"flag":true,"list":[1,2.5,"a text too long for the inline buffer"]})");
+  ASSERT_EQ(value["list"][2], "a text too long for the inline buffer");
+
+  BasicParser<ArenaTraits> arena;
+  Arena reused;
+
+  ASSERT_TRUE(arena.parse_into(R"({"a": 1, "b": 2})", reused));
+  ASSERT_TRUE(arena.parse_into(R"({"c": 3, "b": 4})", reused));
+  ASSERT_EQ(reused.dump(), R"({"b":4,"c":3})");
+}
@@ -0,0 +1,104 @@
+#include "jjson/patch.h"
+
+#include <gtest/gtest.h>
+
+using namespace jjson;
+
+static Json parse(std::string_view data) {
+  return Json::parse(data).value();
+}
+
+TEST(PatchSuite, Pointer) {
+  auto doc = parse(R"({"foo": ["bar", "baz"], "a/b": 1, "m~n": 8})");
+
+  doc.get_or_throw<jObject>()[""] = 0;
+
+  ASSERT_EQ(*Pointer::parse("")->resolve(doc), doc);
+  ASSERT_EQ(*Pointer::parse("/foo/0")->resolve(doc), "bar");
+  ASSERT_EQ(*Pointer::parse("/a~1b")->resolve(doc), int64_t{1});
+  ASSERT_EQ(*Pointer::parse("/m~0n")->resolve(doc), int64_t{8});
+  ASSERT_EQ(*Pointer::parse("/")->resolve(doc), int64_t{0});
+  ASSERT_EQ(Pointer::parse("/foo/2")->resolve(doc), nullptr);
+  ASSERT_EQ(Pointer::parse("/foo/01")->resolve(doc), nullptr);
+  ASSERT_FALSE(Pointer::parse("foo"));
+  ASSERT_FALSE(Pointer::parse("/a~2"));
+  ASSERT_EQ(Pointer::parse("/a~1b/m~0n")->str(), "/a~1b/m~0n");
+}
+
+TEST(PatchSuite, Operations) {
+  auto doc = parse(R"({"foo": "bar", "list": [1, 2, 3]})");
+
+  ASSERT_TRUE(apply_patch(doc, parse(R"([
+    {"op": "add", "path": "/baz", "value": "qux"},
+    {"op": "add", "path": "/list/1", "value": 9},
+    {"op": "add", "path": "/list/-", "value": 4},
+    {"op": "remove", "path": "/list/0"},
+    {"op": "replace", "path": "/foo", "value": [true]},
+    {"op": "copy", "from": "/foo", "path": "/copy"},
+    {"op": "move", "from": "/baz", "path": "/moved"},
+    {"op": "test", "path": "/moved", "value": "qux"}
+  ])")));
+
+  ASSERT_EQ(doc, parse(R"({"foo": [true], "list": [9, 2, 3, 4], "copy": [true], "moved": "qux"})"));
+}
+
+TEST(PatchSuite, Atomic) {
+  auto doc = parse(R"({"foo": {"bar": [1, 2]}, "baz": "qux"})");
+  auto original = doc;
+
+  ASSERT_FALSE(apply_patch(doc, parse(R"([
+    {"op": "add", "path": "/foo/bar/0", "value": 0},
+    {"op": "remove", "path": "/baz"},
+    {"op": "replace", "path": "/foo/bar/1", "value": 10},
+    {"op": "move", "from": "/foo", "path": "/other"},
+    {"op": "add", "path": "/other/new", "value": 1},
+    {"op": "test", "path": "/other/new", "value": 2}
+  ])")));
+
+  ASSERT_EQ(doc, original);
+
+  ASSERT_FALSE(apply_patch(doc, parse(R"([{"op": "remove", "path": "/missing"}])")));
+  ASSERT_FALSE(apply_patch(doc, parse(R"([{"op": "add", "path": "/foo/bar/5", "value": 1}])")));
+  ASSERT_FALSE(apply_patch(doc, parse(R"([{"op": "move", "from": "/foo", "path": "/foo/child"}])")));
+  ASSERT_FALSE(apply_patch(doc, parse(R"([{"op": "unknown", "path": "/foo"}])")));
+  ASSERT_FALSE(apply_patch(doc, parse(R"([{"op": "add", "path": "/foo"}])")));
+  ASSERT_EQ(doc, original);
+}
+
+TEST(PatchSuite, MergePatch) {
+  auto doc = parse(R"({"title": "Goodbye!", "author": {"givenName": "John", "familyName": "Doe"}, "tags": ["example", "sample"], "content": "This will be unchanged"})");
+
+  apply_merge_patch(doc, parse(R"({"title": "Hello!", "phoneNumber": "+01-123-456-7890", "author": {"familyName": null}, "tags": ["example"]})"));
+
+  ASSERT_EQ(doc, parse(R"({"title": "Hello!", "author": {"givenName": "John"}, "tags": ["example"], "content": "This will be unchanged", "phoneNumber": "+01-123-456-7890"})"));
+
+  Json scalar{42};
+
+  apply_merge_patch(scalar, parse(R"({"a": {"b": null, "c": 1}})"));
+
+  ASSERT_EQ(scalar, parse(R"({"a": {"c": 1}})"));
+}
+
+TEST(PatchSuite, Diff) {
+  std::vector<std::pair<std::string, std::string>> cases{
+    {R"({"a": 1, "b": [1, 2, 3, 4], "c": {"d": "e"}})", R"({"a": 2, "b": [1, 5, 4], "c": {"f": null}, "g": true})"},
+    {R"([1, 2, 3])", R"([0, 1, 2, 3, 4])"},
+    {R"([1, 2, 3])", R"([])"},
+    {R"({"a": 1})", R"([1])"},
+    {R"("x")", R"("x")"}
+  };
+
+  for (auto const &[source, target] : cases) {
+    auto a = parse(source);
+    auto b = parse(target);
+    auto patch = diff(a, b);
+
+    ASSERT_TRUE(apply_patch(a, patch)) << patch;
+    ASSERT_EQ(a, b) << patch;
+  }
+
+  auto patch = diff(parse(R"({"big": [1, 2, 3, 4, 5, 6, 7, 8], "x": 1})"), parse(R"({"big": [1, 2, 3, 4, 0, 6, 7, 8], "x": 1})"));
+
+  ASSERT_EQ(patch, parse(R"([{"op": "replace", "path": "/big/4", "value": 0}])"));
+  ASSERT_EQ(diff(parse("[]"), parse("[]")).get_or_throw<jArray>().size(), 0);
+}
@@ -0,0 +1,154 @@
+#include "jjson/path.h"
+
+#include <gtest/gtest.h>
+
+using namespace jjson;
+
+static std::string const store = R"({
+  "store": {
+    "book": [
+      {"category": "reference", "author": "Nigel Rees", "title": "Sayings of the Century", "price": 8.95},
+      {"category": "fiction", "author": "Evelyn Waugh", "title": "Sword of Honour", "price": 12.99},
+      {"category": "fiction", "author": "Herman Melville", "title": "Moby Dick", "isbn": "0-553-21311-3", "price": 8.99},
+      {"category": "fiction", "author": "J. R. R. Tolkien", "title": "The Lord of the Rings", "isbn": "0-395-19395-8", "price": 22.99}
+    ],
+    "bicycle": {"color": "red", "price": 399}
+  }
+})";
+
+// dumps of the matches, sorted since object members have no order
+static std::vector<std::string> sorted(std::vector<Json> const &values) {
+  std::vector<std::string> result;
+
+  for (auto const &value : values) {
+    result.push_back(value.dump());
+  }
+
+  std::sort(result.begin(), result.end());
+
+  return result;
+}
+
+// matches of path in data, checking that select() and scan() agree
+static std::vector<std::string> query(std::string_view path, std::string_view data) {
+  auto compiled = JsonPath::compile(path).value();
+  auto document = Json::parse(data).value();
+  std::vector<Json> selected;
+
+  for (auto const *value : compiled.select(document)) {
+    selected.push_back(*value);
+  }
+
+  auto scanned = compiled.scan(data);
+
+  EXPECT_TRUE(scanned) << path;
+  EXPECT_EQ(sorted(selected), sorted(scanned.value_or(std::vector<Json>{}))) << path;
+
+  return sorted(selected);
+}
+
+static std::vector<std::string> dumps(std::initializer_list<std::string_view> values) {
+  std::vector<Json> result;
+
+  for (auto value : values) {
+    result.push_back(Json::parse(value).value());
+  }
+
+  return sorted(result);
+}
+
+TEST(PathSuite, Compile) {
+  for (auto path : {"$", "$.a", "$['a']", "$[\"a\"]", "$.*", "$[*]", "$..a", "$..*", "$..[0]", "$[0]", "$[-1]",
+        "$[1:2]", "$[::-1]", "$[:]", "$[0, 'a', *]", "$ .a [0]", "$[?@.a]", "$[?!@.a]", "$[?(@.a == 1 || @.b)]",
+        "$[?@.a == 'x' && @['b'][0] >= -1.5e3]", "$[?@ != null]", "$.ünïcode", "$['it\\'s']", "$[0:10:1]",
+        "$[-10]", "$[0, 10]"}) {
+    ASSERT_TRUE(JsonPath::compile(path)) << path;
+  }
+
+  for (auto path : {"", "a", "$.", "$..", "$[", "$[]", "$[0", "$['a]", "$.0a", "$[1:2:3:4]", "$[?]", "$[?1]",
+        "$[?@.a ==]", "$[?(@.a]", "$[?@.a == [1]]", "$ a", "$[01]", "$[-0]", "$[-01]", "$[1:02]", "$[::-0]",
+        "$[00:1]"}) {
+    ASSERT_FALSE(JsonPath::compile(path)) << path;
+  }
+}
+
+TEST(PathSuite, Selectors) {
+  ASSERT_EQ(query("$.store.book[*].author", store),
+      dumps({R"("Nigel Rees")", R"("Evelyn Waugh")", R"("Herman Melville")", R"("J. R. R. Tolkien")"}));
+  ASSERT_EQ(query("$..author", store), query("$.store.book[*].author", store));
+  ASSERT_EQ(query("$.store..price", store), dumps({"8.95", "12.99", "8.99", "22.99", "399"}));
+  ASSERT_EQ(query("$..book[2].title", store), dumps({R"("Moby Dick")"}));
+  ASSERT_EQ(query("$..book[-1].title", store), dumps({R"("The Lord of the Rings")"}));
+  ASSERT_EQ(query("$..book[0,1].price", store), dumps({"8.95", "12.99"}));
+  ASSERT_EQ(query("$..book[:2].price", store), dumps({"8.95", "12.99"}));
+  ASSERT_EQ(query("$..book[-2:].price", store), dumps({"8.99", "22.99"}));
+  ASSERT_EQ(query("$..book[::2].price", store), dumps({"8.95", "8.99"}));
+  ASSERT_EQ(query("$..book[::-3].price", store), dumps({"22.99", "8.95"}));
+  ASSERT_EQ(query("$..book[5]", store), dumps({}));
+  ASSERT_EQ(query("$['store']['bicycle']", store), dumps({R"({"color": "red", "price": 399})"}));
+  ASSERT_EQ(query("$.store.*", store).size(), 2u);
+  ASSERT_EQ(query("$..*", store).size(), 27u);
+  ASSERT_EQ(query("$", "42"), dumps({"42"}));
+
+  // selectors are applied one after another, keeping repeated matches
+  ASSERT_EQ(query("$[0, 0, -3]", "[1, 2, 3]"), dumps({"1", "1", "1"}));
+  ASSERT_EQ(query("$[5:0:-2]", "[0, 1, 2, 3, 4, 5, 6]"), dumps({"5", "3", "1"}));
+  ASSERT_EQ(query("$[1:5:0]", "[0, 1, 2]"), dumps({}));
+  ASSERT_EQ(query("$[-100:100]", "[0, 1]"), dumps({"0", "1"}));
+  ASSERT_EQ(query("$..a..b", R"({"a": {"a": {"b": 1}}})"), dumps({"1", "1"}));
+}
+
+TEST(PathSuite, Filters) {
+  std::string items = R"({"items": [
+    {"type": "donut", "price": 12, "tags": ["a"]},
+    {"type": "donut", "price": 8.5},
+    {"type": "bagel", "price": 20, "size": {"w": 3}},
+    {"type": "donut", "price": 10.5, "tags": []},
+    {"type": "donut", "price": "11"},
+    [1, 2],
+    7
+  ]})";
+
+  ASSERT_EQ(query("$.items[?@.price > 10 && @.type == 'donut'].price", items), dumps({"12", "10.5"}));
+  ASSERT_EQ(query("$.items[?(@.price < 10 || @.type == \"bagel\")].price", items), dumps({"8.5", "20"}));
+  ASSERT_EQ(query("$.items[?@.tags].price", items), dumps({"12", "10.5"}));
+  ASSERT_EQ(query("$.items[?!@.tags && @.price >= 20].type", items), dumps({R"("bagel")"}));
+  ASSERT_EQ(query("$.items[?@.size.w == 3].type", items), dumps({R"("bagel")"}));
+  ASSERT_EQ(query("$.items[?@.tags[0] == 'a'].price", items), dumps({"12"}));
+  ASSERT_EQ(query("$.items[?@.price == '11'].price", items), dumps({R"("11")"}));
+  ASSERT_EQ(query("$.items[?@.price == 12.0].type", items), dumps({R"("donut")"}));
+  ASSERT_EQ(query("$.items[?@.missing == @.other].price", items).size(), 5u);
+  ASSERT_EQ(query("$.items[?@ == 7]", items), dumps({"7"}));
+  ASSERT_EQ(query("$.items[?@[1] > 1]", items), dumps({"[1, 2]"}));
+  ASSERT_EQ(query("$[?@[0] == @[1]]", R"([[{"a": 1}, {"a": 2}], [{"a": 3}, {"a": 3}]])"),
+      dumps({R"([{"a": 3}, {"a": 3}])"}));
+  ASSERT_EQ(query("$[?@ == @]", R"([{"a": 1}, [2]])").size(), 2u);
+  ASSERT_EQ(query("$..[?@.w]", items), dumps({R"({"w": 3})"}));
+  ASSERT_EQ(query("$.items[?@.type > 'c'].price", items).size(), 4u);
+}
+
+TEST(PathSuite, Scan) {
+  auto path = JsonPath::compile("$.rows[*].id").value();
+
+  // values that aren't reached are skipped, but still checked
+  auto result = path.scan(R"({"skipped": [1, {"y": true}], "rows": [{"id": 1, "blob": [2, "]"]}, {"id": 2}]})");
+  ASSERT_TRUE(result);
+  ASSERT_EQ(*result, (std::vector<Json>{Json{1}, Json{2}}));
+
+  ASSERT_FALSE(path.scan(R"({"skipped": [1x], "rows": []})"));
+  ASSERT_FALSE(path.scan(R"({"skipped": {"y": tru}, "rows": []})"));
+  ASSERT_FALSE(path.scan(R"({"skipped": [1}, "rows": []})"));
+  ASSERT_FALSE(path.scan(R"({"skipped": , "rows": []})"));
+  ASSERT_FALSE(path.scan(R"({"rows": [{"id": 1, "blob": 2z}]})"));
+
+  // matches come in source order
+  ASSERT_EQ(*JsonPath::compile("$..id").value().scan(R"([{"id": 3}, {"id": 1}, [{"id": 2}]])"),
+      (std::vector<Json>{Json{3}, Json{1}, Json{2}}));
+
+  ASSERT_FALSE(path.scan(R"({"rows": [{"id": 1x}]})"));
+  ASSERT_FALSE(path.scan(R"({"rows": [{"id": 1})"));
+  ASSERT_FALSE(path.scan(R"({"rows": [{"id": 1}})"));
+  ASSERT_FALSE(path.scan(R"({"skipped": "open)"));
+  ASSERT_EQ(path.scan("[]"), std::vector<Json>{});
+  ASSERT_EQ(path.scan(""), std::vector<Json>{});
+}
@@ -0,0 +1,91 @@
+#include "jjson/projection.h"
+
+#include <gtest/gtest.h>
+
+using namespace jjson;
+
+static Json parse(std::string_view data) {
+  return Json::parse(data).value();
+}
+
+TEST(ProjectionSuite, Paths) {
+  auto data = R"({
+    "id": 1,
+    "message": "a \"quoted\" message with [brackets] and {braces} \\",
+    "user": {"name": "jeff", "roles": ["admin", "user"], "address": {"city": "x", "zip": "y"}},
+    "items": [
+      {"id": 1, "tags": ["a"], "price": 1.5},
+      {"id": 2, "tags": [], "price": 2.5, "extra": {"deep": [[[]]]}}
+    ],
+    "flag": true
+  })";
+
+  ASSERT_EQ(Json::parse(data, Projection{"id"}), parse(R"({"id": 1})"));
+  ASSERT_EQ(Json::parse(data, Projection{"user.name", "flag"}), parse(R"({"user": {"name": "jeff"}, "flag": true})"));
+  ASSERT_EQ(Json::parse(data, Projection{"user.address"}), parse(R"({"user": {"address": {"city": "x", "zip": "y"}}})"));
+  ASSERT_EQ(Json::parse(data, Projection{"items.price"}), parse(R"({"items": [{"price": 1.5}, {"price": 2.5}]})"));
+  ASSERT_EQ(Json::parse(data, Projection{"missing"}), parse(R"({})"));
+  ASSERT_EQ(Json::parse(data, Projection{"message"}).value()["message"],
+      parse(data)["message"]);
+
+  Projection projection;
+
+  projection.add(std::vector<std::string>{"a.b"});
+
+  ASSERT_EQ(Json::parse(R"({"a.b": 1, "a": {"b": 2}})", projection), parse(R"({"a.b": 1})"));
+}
+
+TEST(ProjectionSuite, Whole) {
+  Projection projection;
+
+  projection.add(std::vector<std::string>{});
+
+  ASSERT_EQ(Json::parse(R"({"a": [1, {"b": 2}], "c": null})", projection), parse(R"({"a": [1, {"b": 2}], "c": null})"));
+}
+
+TEST(ProjectionSuite, Invalid) {
+  ASSERT_FALSE(Json::parse(R"({"a": 1, "b": "unterminated})", Projection{"a"}));
+  ASSERT_FALSE(Json::parse(R"({"a": 1, "b": [1, 2})", Projection{"a"}));
+  ASSERT_FALSE(Json::parse(R"({"a": 1, "b": 2)", Projection{"a"}));
+  ASSERT_FALSE(Json::parse(R"({"a": 1, "b": })", Projection{"a"}));
+  ASSERT_FALSE(Json::parse(R"({"a": 1, "b": [1}})", Projection{"a"}));
+  ASSERT_FALSE(Json::parse(R"({"a": 1, "b": {"c": [}]})", Projection{"a"}));
+  ASSERT_FALSE(Json::parse(R"({"a": 1, "b": [1x]})", Projection{"a"}));
+  ASSERT_FALSE(Json::parse(R"({"a": 1, "b": {"c": tru}})", Projection{"a"}));
+  ASSERT_FALSE(Json::parse(R"({"a": 1, "b": nullx})", Projection{"a"}));
+  ASSERT_FALSE(Json::parse(R"([{"a": 1, "b": -}])", Projection{"a"}));
+
+  // skipped members keep the parser's number formats
+  ASSERT_EQ(Json::parse(R"({"a": 1, "b": [0x1f, .5, -2.0e-3, 017, null, false]})", Projection{"a"}), parse(R"({"a": 1})"));
+}
+
+TEST(ProjectionSuite, Skip) {
+  ParseState ps{};
+  std::string_view data{R"("a\\" , "b\"c" , [1, {"x": "]"}] , 1234 , tail)"};
+
+  ps = ParseState{data.data(), data.data() + data.size()};
+
+  ASSERT_TRUE(ps.skip_value());
+  ASSERT_EQ(std::string_view(data.data(), ps.p), R"("a\\")");
+  ps.skip_space();
+  ps.get();
+  ASSERT_TRUE(ps.skip_value());
+  ps.skip_space();
+  ps.get();
+  ASSERT_TRUE(ps.skip_value());
+  ASSERT_EQ(ps.peek(), ' ');
+  ps.skip_space();
+  ps.get();
+  ASSERT_TRUE(ps.skip_value());
+  ps.skip_space();
+  ASSERT_EQ(std::string_view(ps.p, ps.end), ", tail");
+}
+
+TEST(ProjectionSuite, SkipInvalid) {
+  for (std::string_view data : {"", " ", "]", "}", ",", ":", "[1}", "{]", "[[1]", "\"open", "tru", "nul", "1x",
+        "1.5.5", "-", "x", "[1, fals]", "true1"}) {
+    ParseState ps{data.data(), data.data() + data.size()};
+
+    ASSERT_FALSE(ps.skip_value()) << data;
+  }
+}
@@ -0,0 +1,94 @@
+#include "jjson/schema.h"
+
+#include <gtest/gtest.h>
+
+using namespace jjson;
+
+static Json parse(std::string_view data) {
+  return Json::parse(data).value();
+}
+
+static Schema user() {
+  return Schema::compile(parse(R"({
+    "type": "object",
+    "required": ["id", "name"],
+    "properties": {
+      "id": {"type": "integer", "minimum": 1},
+      "name": {"type": "string", "maxLength": 8},
+      "role": {"enum": ["admin", "user"]},
+      "score": {"type": "number", "exclusiveMaximum": 100},
+      "tags": {"type": "array", "items": {"type": "string"}}
+    },
+    "additionalProperties": false
+  })")).value();
+}
+
+TEST(SchemaSuite, Compile) {
+  ASSERT_TRUE(Schema::compile(parse("{}")));
+  ASSERT_TRUE(Schema::compile(parse("true")));
+  ASSERT_FALSE(Schema::compile(parse("1")));
+  ASSERT_FALSE(Schema::compile(parse(R"({"type": "unknown"})")));
+  ASSERT_FALSE(Schema::compile(parse(R"({"required": "id"})")));
+  ASSERT_FALSE(Schema::compile(parse(R"({"maxLength": -1})")));
+  ASSERT_FALSE(Schema::compile(parse(R"({"properties": {"a": 1}})")));
+}
+
+TEST(SchemaSuite, Validate) {
+  auto schema = user();
+
+  ASSERT_TRUE(schema.validate(parse(R"({"id": 1, "name": "jeff"})")));
+  ASSERT_TRUE(schema.validate(parse(R"({"id": 2, "name": "ação", "role": "admin", "score": 99.5, "tags": ["a", "b"]})")));
+  ASSERT_FALSE(schema.validate(parse(R"({"id": 1})")));
+  ASSERT_FALSE(schema.validate(parse(R"({"id": 0, "name": "jeff"})")));
+  ASSERT_FALSE(schema.validate(parse(R"({"id": 1.5, "name": "jeff"})")));
+  ASSERT_FALSE(schema.validate(parse(R"({"id": 1, "name": "too long name"})")));
+  ASSERT_FALSE(schema.validate(parse(R"({"id": 1, "name": "jeff", "role": "root"})")));
+  ASSERT_FALSE(schema.validate(parse(R"({"id": 1, "name": "jeff", "score": 100})")));
+  ASSERT_FALSE(schema.validate(parse(R"({"id": 1, "name": "jeff", "tags": ["a", 1]})")));
+  ASSERT_FALSE(schema.validate(parse(R"({"id": 1, "name": "jeff", "other": 1})")));
+  ASSERT_FALSE(schema.validate(parse(R"([1])")));
+}
+
+TEST(SchemaSuite, ParseFused) {
+  auto schema = user();
+
+  ASSERT_TRUE(Json::parse(R"({"id": 1, "name": "jeff", "tags": ["x"]})", schema.validator()));
+  ASSERT_FALSE(Json::parse(R"({"id": 1})", schema.validator()));
+  ASSERT_FALSE(Json::parse(R"({"id": 1, "name": "jeff", "tags": ["a", 1]})", schema.validator()));
+  ASSERT_FALSE(Json::parse(R"([1, 2, 3])", schema.validator()));
+
+  // the parse stops at the first violation, so the rest is never scanned
+  ASSERT_FALSE(Json::parse(R"({"id": -1, "name": "jeff", "tags": ["a", "b", "c"]})", schema.validator()));
+
+  auto any = Schema::compile(parse("{}")).value();
+
+  ASSERT_EQ(Json::parse(R"({"a": [1, {"b": null}]})", any.validator()), parse(R"({"a": [1, {"b": null}]})"));
+}
+
+TEST(SchemaSuite, EarlyAbort) {
+  struct CountingFilter {
+    int *values;
+
+    bool begin(JsonType) const {
+      return true;
+    }
+
+    bool end(Json const &value) const {
+      ++*values;
+      return !value.is_bool();
+    }
+
+    CountingFilter member(std::string const &) const {
+      return *this;
+    }
+
+    CountingFilter element(std::size_t) const {
+      return *this;
+    }
+  };
+
+  int values = 0;
+
+  ASSERT_FALSE(Json::parse("[1, 2, true, 4, 5, 6]", CountingFilter{&values}));
+  ASSERT_EQ(values, 3);
+}
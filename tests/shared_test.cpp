@@ -0,0 +1,143 @@
+#include "jjson/shared.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace jjson;
+
+static Json parse(std::string_view data) {
+  return Json::parse(data).value();
+}
+
+TEST(SharedSuite, RoundTrip) {
+  auto doc = parse(R"({"a": [1, 2.5, "x", null, true], "b": {"c": {"d": "e"}}})");
+  SharedJson shared{doc};
+
+  ASSERT_EQ(shared.json(), doc);
+  ASSERT_EQ(shared["a"][1].get<double>(), 2.5);
+  ASSERT_EQ(shared["a"][2].get<std::string>(), "x");
+  ASSERT_EQ(shared["b"]["c"]["d"].get<std::string>(), "e");
+  ASSERT_EQ(shared["a"].size(), 5);
+  ASSERT_TRUE(shared.has("b"));
+  ASSERT_FALSE(shared.has("z"));
+  ASSERT_THROW(shared["z"], std::runtime_error);
+}
+
+TEST(SharedSuite, Snapshot) {
+  SharedJson config{parse(R"({"routes": {"a": [1, 2, 3]}, "limits": {"rate": 10}})")};
+  SharedJson snapshot = config;
+
+  ASSERT_TRUE(snapshot.shares(config));
+
+  config.edit("limits").set("rate", 20);
+  config.edit("routes").edit("a").push_back(4);
+  config.set("extra", "value");
+
+  ASSERT_EQ(snapshot.json(), parse(R"({"routes": {"a": [1, 2, 3]}, "limits": {"rate": 10}})"));
+  ASSERT_EQ(config.json(), parse(R"({"routes": {"a": [1, 2, 3, 4]}, "limits": {"rate": 20}, "extra": "value"})"));
+  ASSERT_FALSE(snapshot.shares(config));
+
+  SharedJson next = config;
+
+  config.edit("limits").set("rate", 30);
+
+  // untouched subtrees stay shared between versions
+  ASSERT_TRUE(next["routes"].shares(config["routes"]));
+  ASSERT_FALSE(next["limits"].shares(config["limits"]));
+  ASSERT_EQ(next["limits"]["rate"].get<int>(), 20);
+
+  ASSERT_TRUE(config.erase("extra"));
+  ASSERT_FALSE(config.erase("extra"));
+  ASSERT_TRUE(next.has("extra"));
+  ASSERT_TRUE(config.edit("routes").edit("a").erase(0));
+  ASSERT_EQ(next["routes"]["a"].size(), 4);
+  ASSERT_EQ(config["routes"]["a"].size(), 3);
+}
+
+TEST(SharedSuite, ConcurrentReaders) {
+  SharedJson config{parse(R"({"version": 0, "data": [1, 2, 3]})")};
+  std::vector<std::thread> readers;
+
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([snapshot = config]() {
+      for (int j = 0; j < 1000; j++) {
+        SharedJson local = snapshot;
+        EXPECT_EQ(local["version"].get<int>(), 0);
+        EXPECT_EQ(local["data"].size(), 3);
+      }
+    });
+  }
+
+  for (int i = 1; i <= 1000; i++) {
+    config.set("version", i);
+    config.edit("data").push_back(i);
+  }
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  ASSERT_EQ(config["version"].get<int>(), 1000);
+  ASSERT_EQ(config["data"].size(), 1003);
+}
+
+TEST(SharedSuite, ConcurrentSnapshots) {
+  SharedJson config{parse(R"({"version": 0, "data": [0, 0, 0, 0, 0, 0, 0, 0]})")};
+  SharedJson published = config;
+  std::mutex mutex;
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+
+  // readers drop their snapshots while the writer decides whether it can
+  // write the shared nodes in place
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        SharedJson snapshot;
+
+        {
+          std::lock_guard lock{mutex};
+          snapshot = published;
+        }
+
+        auto version = snapshot["version"].get<int>();
+        auto before = snapshot.dump();
+
+        // give the writer a chance to run while the snapshot is held
+        std::this_thread::yield();
+
+        for (auto const &value : snapshot["data"].array()) {
+          EXPECT_EQ(value.get<int>(), version);
+        }
+
+        EXPECT_EQ(snapshot.dump(), before);
+      }
+    });
+  }
+
+  for (int i = 1; i <= 2000; i++) {
+    config.set("version", i);
+
+    for (std::size_t j = 0; j < 8; j++) {
+      config.edit("data").set(j, i);
+    }
+
+    {
+      std::lock_guard lock{mutex};
+      published = config;
+    }
+
+    std::this_thread::yield();
+  }
+
+  done = true;
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  ASSERT_EQ(config["data"][7].get<int>(), 2000);
+}
@@ -0,0 +1,67 @@
+#include "jjson/static.h"
+
+#include <gtest/gtest.h>
+
+using namespace jjson;
+
+static constexpr auto config = parse_static<R"({
+  "name": "service",
+  "port": 8080,
+  "ratio": 0.25,
+  "debug": false,
+  "proxy": null,
+  "hosts": ["a.example", "b.example\né😀"],
+  "limits": {"min": -3, "max": 1.5e3, "mask": 0xff, "mode": 0755, "flags": 0b101},
+  "empty": {},
+  "none": []
+})">();
+
+static_assert(config["port"].get<int64_t>() == 8080);
+static_assert(config["name"].get<std::string_view>() == "service");
+static_assert(config["hosts"].size() == 2);
+static_assert(config["limits"]["max"].get<double>() == 1500.0);
+static_assert(config["limits"]["mask"].get<int>() == 255);
+static_assert(!config.root().has("missing"));
+
+template <FixedString Source>
+concept ValidLiteral = requires {
+  typename std::integral_constant<std::size_t, detail::static_sizes<Source>().nodes>;
+};
+
+static_assert(ValidLiteral<"[1, 2]">);
+static_assert(!ValidLiteral<"[1, 2">);
+static_assert(!ValidLiteral<R"({"a": 1, "a": 2})">);
+static_assert(!ValidLiteral<R"({"a": tru})">);
+static_assert(!ValidLiteral<R"("\x")">);
+static_assert(!ValidLiteral<"99999999999999999999">);
+static_assert(!ValidLiteral<"[1] 2">);
+static_assert(!ValidLiteral<"">);
+
+TEST(StaticSuite, Lookup) {
+  auto root = config.root();
+
+  ASSERT_TRUE(root.is_object());
+  ASSERT_EQ(root.size(), 9);
+  ASSERT_EQ(root["ratio"].get<double>(), 0.25);
+  ASSERT_EQ(root["debug"].get<bool>(), false);
+  ASSERT_TRUE(root["proxy"].is_null());
+  ASSERT_EQ(root["hosts"][1].get<std::string>(), "b.example\né\U0001F600");
+  ASSERT_EQ(root["limits"]["min"].get<int>(), -3);
+  ASSERT_EQ(root["limits"]["mode"].get<int>(), 0755);
+  ASSERT_EQ(root["limits"]["flags"].get<int>(), 5);
+  ASSERT_EQ(root["empty"].size(), 0);
+  ASSERT_TRUE(root["none"].is_array());
+  ASSERT_EQ(root.key(0), "debug");
+  ASSERT_THROW(root["missing"], std::runtime_error);
+  ASSERT_THROW(root["hosts"][2], std::runtime_error);
+  ASSERT_FALSE(root["port"].get<std::string_view>());
+}
+
+TEST(StaticSuite, MatchesRuntime) {
+  static constexpr auto doc = parse_static<R"([0, -0.5, 3.14159, 1.0e0, 2.5e-3, 123456.789, .5, 1.0, -9223372036854775808, "\"\\\/\b\f\r\t"])">();
+
+  auto expected = Json::parse(R"([0, -0.5, 3.14159, 1.0e0, 2.5e-3, 123456.789, .5, 1.0, -9223372036854775808, "\"\\\/\b\f\r\t"])").value();
+
+  ASSERT_EQ(doc.root().json(), expected);
+  ASSERT_EQ(config.root().json(), Json::parse(config.root().dump()).value());
+}
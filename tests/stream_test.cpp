@@ -0,0 +1,91 @@
+#include "jjson/stream.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include <unistd.h>
+
+using namespace jjson;
+
+static Json parse(std::string_view data) {
+  return Json::parse(data).value();
+}
+
+static std::string const data = R"({"a": 1}{"b": [2, "]}"]}
+[1, {"c": "x\"{"}]   "text""more" 42 -1.5e3
+true null false{"last": {}}
+)";
+
+static std::vector<Json> const expected{
+  parse(R"({"a": 1})"),
+  parse(R"({"b": [2, "]}"]})"),
+  parse(R"([1, {"c": "x\"{"}])"),
+  Json{"text"},
+  Json{"more"},
+  Json{42},
+  Json{-1.5e3},
+  Json{true},
+  Json{},
+  Json{false},
+  parse(R"({"last": {}})")
+};
+
+TEST(StreamSuite, Documents) {
+  // every chunk size splits the documents at different places
+  for (std::size_t chunkSize : {1, 2, 3, 7, 64, 4096}) {
+    std::istringstream is{data};
+    std::vector<Json> result;
+
+    for (auto &&document : documents(is, chunkSize)) {
+      result.push_back(std::move(document));
+    }
+
+    ASSERT_EQ(result, expected) << chunkSize;
+  }
+
+  std::istringstream empty{" \n "};
+
+  for (auto &&document : documents(empty)) {
+    FAIL() << document;
+  }
+}
+
+TEST(StreamSuite, Descriptor) {
+  int fds[2];
+
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_EQ(write(fds[1], data.data(), data.size()), static_cast<ssize_t>(data.size()));
+  close(fds[1]);
+
+  std::vector<Json> result;
+
+  for (auto &&document : documents(fds[0], 5)) {
+    result.push_back(std::move(document));
+  }
+
+  close(fds[0]);
+
+  ASSERT_EQ(result, expected);
+}
+
+TEST(StreamSuite, Errors) {
+  std::istringstream invalid{R"({"a": 1} {"b": tru} {"c": 3})"};
+  std::vector<Json> result;
+
+  ASSERT_THROW({
+    for (auto &&document : documents(invalid, 4)) {
+      result.push_back(std::move(document));
+    }
+  }, std::runtime_error);
+
+  ASSERT_EQ(result, std::vector<Json>{parse(R"({"a": 1})")});
+
+  std::istringstream truncated{R"([1, 2] {"a": [1)"};
+  DocumentStream stream{truncated, 3};
+  Json document;
+
+  ASSERT_TRUE(stream.next(document));
+  ASSERT_EQ(document, parse("[1, 2]"));
+  ASSERT_THROW(stream.next(document), std::runtime_error);
+}